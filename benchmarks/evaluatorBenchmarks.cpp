@@ -0,0 +1,180 @@
+#include <benchmark/benchmark.h>
+
+#include "backend/evaluator/evaluator.h"
+
+namespace {
+
+// a row of inverters wired into a ring so the simulation has something to do while edits come in
+void buildRing(Circuit& circuit, unsigned int gateCount) {
+	const cord_t width = gateCount;
+	circuit.tryInsertOverArea(Position(0, 0), Position(width - 1, 0), Rotation::ZERO, BlockType::NOR);
+	for (cord_t x = 0; x < width; ++x) {
+		circuit.tryCreateConnection(Position(x, 0), Position((x + 1) % width, 0));
+	}
+}
+
+// args are the gates already in the circuit, the blocks placed per edit and whether the simulation is running.
+// times a difference going from the circuit through Evaluator::makeEdit until a read can see it
+void editLatency(benchmark::State& state) {
+	const unsigned int backgroundGates = state.range(0);
+	const unsigned int editSize = state.range(1);
+	const bool running = state.range(2);
+
+	SharedCircuit circuit = std::make_shared<Circuit>(1);
+	Evaluator evaluator(1, circuit);
+	if (backgroundGates) buildRing(*circuit, backgroundGates);
+	evaluator.setUseTickrate(false);
+	evaluator.setPause(!running);
+
+	cord_t row = 1;
+	for (auto _ : state) {
+		// one difference for the whole row, the circuit hands it to makeEdit
+		circuit->tryInsertOverArea(Position(0, row), Position(editSize - 1, row), Rotation::ZERO, BlockType::AND);
+		benchmark::DoNotOptimize(evaluator.getState(Address(Position(editSize - 1, row))));
+		++row;
+	}
+	evaluator.setPause(true);
+	state.SetItemsProcessed(state.iterations() * editSize);
+}
+
+void editArgs(benchmark::internal::Benchmark* benchmark) {
+	benchmark->ArgNames({ "gates", "edit", "running" });
+	for (int backgroundGates : { 0, 1 << 16 }) {
+		for (int editSize : { 1, 1024 }) {
+			for (int running : { 0, 1 }) {
+				benchmark->Args({ backgroundGates, editSize, running });
+			}
+		}
+	}
+}
+
+// what the renderer does every frame, looks up the gate of every block and reads its state
+void bulkStateRead(benchmark::State& state) {
+	const unsigned int side = state.range(0);
+	SharedCircuit circuit = std::make_shared<Circuit>(1);
+	Evaluator evaluator(1, circuit);
+	circuit->tryInsertOverArea(Position(0, 0), Position(side - 1, side - 1), Rotation::ZERO, BlockType::AND);
+	// same order as the renderer
+	std::vector<Address> addresses;
+	for (const auto& block : *(circuit->getBlockContainer())) {
+		addresses.push_back(Address(block.getPosition()));
+	}
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(evaluator.getBulkStates(addresses));
+	}
+	state.SetItemsProcessed(state.iterations() * addresses.size());
+}
+
+// removes one block at a time from a square of blocks, compaction should only cost the removed gates
+void removeLatency(benchmark::State& state) {
+	const unsigned int side = state.range(0);
+	SharedCircuit circuit = std::make_shared<Circuit>(1);
+	Evaluator evaluator(1, circuit);
+	// the reorder after placing the square would land in the first timed removal
+	evaluator.setAutoReorder(false);
+	circuit->tryInsertOverArea(Position(0, 0), Position(side - 1, side - 1), Rotation::ZERO, BlockType::AND);
+	const Address probe(Position(side - 1, side - 1));
+	// waits for the square to be placed
+	evaluator.getState(probe);
+	unsigned int removed = 0;
+	for (auto _ : state) {
+		// from the front so the blocks at the end have to be moved
+		circuit->tryRemoveBlock(Position(removed % side, removed / side));
+		benchmark::DoNotOptimize(evaluator.getState(probe));
+		if (++removed == side * (side - 1)) {
+			// put the removed rows back, the probe row is never removed
+			state.PauseTiming();
+			circuit->tryInsertOverArea(Position(0, 0), Position(side - 1, side - 2), Rotation::ZERO, BlockType::AND);
+			evaluator.getState(probe);
+			removed = 0;
+			state.ResumeTiming();
+		}
+	}
+}
+
+// an importer placing a square of blocks one at a time, each wired to its right neighbour, until the evaluator has it.
+// with a transaction the circuit sends one difference instead of one per call
+void pasteDesign(benchmark::State& state) {
+	const cord_t side = state.range(0);
+	const bool transaction = state.range(1);
+	for (auto _ : state) {
+		SharedCircuit circuit = std::make_shared<Circuit>(1);
+		Evaluator evaluator(1, circuit);
+		if (transaction) circuit->beginTransaction(side * side * 2);
+		for (cord_t x = 0; x < side; ++x) {
+			for (cord_t y = 0; y < side; ++y) {
+				circuit->tryInsertBlock(Position(x, y), Rotation::ZERO, BlockType::AND);
+			}
+		}
+		for (cord_t x = 0; x + 1 < side; ++x) {
+			for (cord_t y = 0; y < side; ++y) {
+				circuit->tryCreateConnection(Position(x, y), Position(x + 1, y));
+			}
+		}
+		if (transaction) circuit->commitTransaction();
+		benchmark::DoNotOptimize(evaluator.getState(Address(Position(side - 1, side - 1))));
+	}
+	state.SetItemsProcessed(state.iterations() * side * side);
+}
+
+// filling an empty square in one call, the collision check is done once for the whole area
+void areaFill(benchmark::State& state) {
+	const cord_t side = state.range(0);
+	for (auto _ : state) {
+		Circuit circuit(1);
+		circuit.tryInsertOverArea(Position(0, 0), Position(side - 1, side - 1), Rotation::ZERO, BlockType::AND);
+		benchmark::DoNotOptimize(circuit.getBlockContainer()->getBlockCount());
+	}
+	state.SetItemsProcessed(state.iterations() * side * side);
+}
+
+// a square of blocks each wired to its right neighbour, in one undo step
+void pasteSquare(Circuit& circuit, cord_t side) {
+	circuit.beginTransaction(side * side * 2);
+	circuit.tryInsertOverArea(Position(0, 0), Position(side - 1, side - 1), Rotation::ZERO, BlockType::AND);
+	for (cord_t x = 0; x + 1 < side; ++x) {
+		for (cord_t y = 0; y < side; ++y) {
+			circuit.tryCreateConnection(Position(x, y), Position(x + 1, y));
+		}
+	}
+	circuit.commitTransaction();
+}
+
+// reading every modification of a large difference like the evaluator and saving do, also reports its size
+void differenceScan(benchmark::State& state) {
+	const cord_t side = state.range(0);
+	Circuit circuit(1);
+	pasteSquare(circuit, side);
+	const Difference difference = circuit.getBlockContainer()->getCreationDifference();
+	for (auto _ : state) {
+		long long sum = 0;
+		for (const auto& [modificationType, modificationData] : difference.getModifications()) {
+			sum += modificationType + std::visit([](const auto& data) { return std::get<0>(data).x; }, modificationData);
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.counters["bytes/modification"] = (double)difference.memoryUsage() / difference.size();
+	state.SetItemsProcessed(state.iterations() * difference.size());
+}
+
+// undoing and redoing a big paste replays its difference through the block container
+void undoPaste(benchmark::State& state) {
+	const cord_t side = state.range(0);
+	Circuit circuit(1);
+	pasteSquare(circuit, side);
+	for (auto _ : state) {
+		circuit.undo();
+		circuit.redo();
+	}
+	state.SetItemsProcessed(state.iterations() * side * side);
+}
+
+} // namespace
+
+BENCHMARK(differenceScan)->Arg(316)->Arg(1024)->Unit(benchmark::kMillisecond);
+BENCHMARK(undoPaste)->Arg(316)->Unit(benchmark::kMillisecond);
+BENCHMARK(pasteDesign)->ArgNames({ "side", "transaction" })->ArgsProduct({ { 64, 316 }, { 0, 1 } })->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(areaFill)->Arg(316)->Arg(1024)->Unit(benchmark::kMillisecond);
+BENCHMARK(removeLatency)->Arg(256)->Arg(1024)->Arg(2048)->Unit(benchmark::kMicrosecond)->UseRealTime();
+BENCHMARK(bulkStateRead)->Arg(64)->Arg(256)->Arg(1024)->Unit(benchmark::kMicrosecond);
+BENCHMARK(editLatency)->Apply(editArgs)->Unit(benchmark::kMicrosecond)->UseRealTime();
@@ -0,0 +1,176 @@
+#include <benchmark/benchmark.h>
+
+#include "backend/position/sparse2d.h"
+#include "backend/container/cell.h"
+#include "backend/container/blockContainer.h"
+
+namespace {
+
+// a half filled square of cells so lookups hit and miss
+template<class Grid>
+void fillCheckerboard(Grid& grid, cord_t side) {
+	for (cord_t x = 0; x < side; ++x) {
+		for (cord_t y = 0; y < side; ++y) {
+			if ((x + y) % 2) grid.insert(Position(x, y), Cell(x * side + y));
+		}
+	}
+}
+
+template<class Grid>
+void gridLookup(benchmark::State& state) {
+	const cord_t side = state.range(0);
+	Grid grid;
+	fillCheckerboard(grid, side);
+	for (auto _ : state) {
+		unsigned int found = 0;
+		for (cord_t x = 0; x < side; ++x) {
+			for (cord_t y = 0; y < side; ++y) {
+				found += grid.get(Position(x, y)) != nullptr;
+			}
+		}
+		benchmark::DoNotOptimize(found);
+	}
+	state.SetItemsProcessed(state.iterations() * side * side);
+}
+
+// the collision check of pasting an area over empty space next to the filled square
+template<class Grid>
+void gridAreaCollision(benchmark::State& state) {
+	const cord_t side = state.range(0);
+	Grid grid;
+	fillCheckerboard(grid, side);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(grid.anyInArea(Position(side, 0), Position(2 * side - 1, side - 1)));
+	}
+	state.SetItemsProcessed(state.iterations() * side * side);
+}
+
+// placing and then removing a large block
+template<class Grid>
+void gridAreaEdit(benchmark::State& state) {
+	const cord_t side = state.range(0);
+	Grid grid;
+	for (auto _ : state) {
+		grid.insertArea(Position(0, 0), Position(side - 1, side - 1), Cell(1));
+		grid.removeArea(Position(0, 0), Position(side - 1, side - 1));
+	}
+	state.SetItemsProcessed(state.iterations() * side * side);
+}
+
+// what the renderer culls each frame, a 64x64 view into a square of blocks each wired to its right neighbour.
+// args are the side of the square and whether to use the spatial index or walk every block like it used to
+void viewportQuery(benchmark::State& state) {
+	const cord_t side = state.range(0);
+	const bool indexed = state.range(1);
+	BlockContainer container;
+	for (cord_t x = 0; x < side; ++x) {
+		for (cord_t y = 0; y < side; ++y) {
+			container.tryInsertBlock(Position(x, y), Rotation::ZERO, BlockType::AND);
+		}
+	}
+	for (cord_t x = 0; x + 1 < side; ++x) {
+		for (cord_t y = 0; y < side; ++y) {
+			container.tryCreateConnection(Position(x, y), Position(x + 1, y));
+		}
+	}
+	const BlockContainer& view = container;
+	const Position topLeft(side / 2, side / 2);
+	const Position bottomRight = topLeft + Vector(63, 63);
+	for (auto _ : state) {
+		unsigned int visible = 0;
+		if (indexed) {
+			visible += view.getBlocksInArea(topLeft, bottomRight).size();
+			visible += view.getConnectionsInArea(topLeft, bottomRight).size();
+		} else {
+			for (const Block& block : view) {
+				if (block.getPosition().withinArea(topLeft, bottomRight)) ++visible;
+				for (connection_end_id_t end = 0; end <= block.getConnectionContainer().getMaxConnectionId(); end++) {
+					if (block.isConnectionInput(end)) continue;
+					const Position position = block.getConnectionPosition(end).first;
+					for (const ConnectionEnd& other : block.getConnectionContainer().getConnections(end)) {
+						const Position otherPosition = view.getBlock(other.getBlockId())->getConnectionPosition(other.getConnectionId()).first;
+						if (position.withinArea(topLeft, bottomRight) || otherPosition.withinArea(topLeft, bottomRight)) ++visible;
+					}
+				}
+			}
+		}
+		benchmark::DoNotOptimize(visible);
+	}
+}
+
+// a 64x64 view into a square of blocks while the rest of the circuit is long wires far off screen.
+// the arg is the number of wires, the query should cost the same however many there are
+void viewportQueryLongWires(benchmark::State& state) {
+	const unsigned int wireCount = state.range(0);
+	const cord_t side = 128;
+	const cord_t wireLength = 4096;
+	BlockContainer container;
+	for (cord_t x = 0; x < side; ++x) {
+		for (cord_t y = 0; y < side; ++y) {
+			container.tryInsertBlock(Position(x, y), Rotation::ZERO, BlockType::AND);
+		}
+	}
+	for (unsigned int wire = 0; wire < wireCount; ++wire) {
+		const Position start(wire % 16 * wireLength, (1 << 16) + wire / 16 * 4);
+		const Position end = start + Vector(wireLength - 1, 0);
+		container.tryInsertBlock(start, Rotation::ZERO, BlockType::AND);
+		container.tryInsertBlock(end, Rotation::ZERO, BlockType::AND);
+		container.tryCreateConnection(start, end);
+	}
+	const BlockContainer& view = container;
+	const Position topLeft(side / 2, side / 2);
+	const Position bottomRight = topLeft + Vector(63, 63);
+	for (auto _ : state) {
+		unsigned int visible = view.getBlocksInArea(topLeft, bottomRight).size();
+		visible += view.getConnectionsInArea(topLeft, bottomRight).size();
+		benchmark::DoNotOptimize(visible);
+	}
+}
+
+// a full pass over every block like making the creation difference or saving does
+void blockScan(benchmark::State& state) {
+	const cord_t side = state.range(0);
+	BlockContainer container;
+	for (cord_t x = 0; x < side; ++x) {
+		for (cord_t y = 0; y < side; ++y) {
+			container.tryInsertBlock(Position(x, y), Rotation::ZERO, BlockType::AND);
+		}
+	}
+	const BlockContainer& view = container;
+	for (auto _ : state) {
+		long long sum = 0;
+		for (const Block& block : view) {
+			sum += block.getPosition().x + block.type();
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * side * side);
+}
+
+// filling a square with blocks, mostly allocations
+void blockInsert(benchmark::State& state) {
+	const cord_t side = state.range(0);
+	for (auto _ : state) {
+		BlockContainer container;
+		for (cord_t x = 0; x < side; ++x) {
+			for (cord_t y = 0; y < side; ++y) {
+				container.tryInsertBlock(Position(x, y), Rotation::ZERO, BlockType::AND);
+			}
+		}
+		benchmark::DoNotOptimize(container.getBlockCount());
+	}
+	state.SetItemsProcessed(state.iterations() * side * side);
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(gridLookup, Sparse2dArray<Cell>)->Arg(64)->Arg(1024)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(gridLookup, Sparse2dChunked<Cell>)->Arg(64)->Arg(1024)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(gridAreaCollision, Sparse2dArray<Cell>)->Arg(64)->Arg(1024)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(gridAreaCollision, Sparse2dChunked<Cell>)->Arg(64)->Arg(1024)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(gridAreaEdit, Sparse2dArray<Cell>)->Arg(8)->Arg(256)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(gridAreaEdit, Sparse2dChunked<Cell>)->Arg(8)->Arg(256)->Unit(benchmark::kMicrosecond);
+BENCHMARK(viewportQuery)->ArgNames({ "side", "indexed" })->ArgsProduct({ { 128, 512, 2048 }, { 0, 1 } })->Unit(benchmark::kMicrosecond);
+BENCHMARK(viewportQueryLongWires)->Arg(0)->Arg(4096)->Arg(65536)->Unit(benchmark::kMicrosecond);
+BENCHMARK(blockScan)->Arg(1024)->Unit(benchmark::kMicrosecond);
+BENCHMARK(blockInsert)->Arg(1024)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,100 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+#include "backend/evaluator/gateKernels.h"
+
+namespace {
+
+constexpr unsigned int GATE_COUNT = 1 << 16;
+constexpr unsigned int WORD_COUNT = GATE_COUNT / STATE_WORD_BITS;
+
+struct GatePopulation {
+	std::vector<GateType> types;
+	std::vector<GateTypeMasks> masks;
+	std::vector<unsigned int> powered, total;
+	std::vector<state_word_t> current, next;
+};
+
+// uniform populations are sorted by type like compressGates leaves them, mixed ones are shuffled
+GatePopulation makePopulation(bool uniform) {
+	const std::vector<GateType> logicTypes = { GateType::AND, GateType::OR, GateType::XOR, GateType::NAND, GateType::NOR, GateType::XNOR };
+	std::mt19937 random(1);
+	GatePopulation population;
+	population.types.resize(GATE_COUNT);
+	population.masks.resize(WORD_COUNT);
+	population.powered.resize(GATE_COUNT);
+	population.total.resize(GATE_COUNT);
+	population.current.resize(WORD_COUNT);
+	population.next.resize(WORD_COUNT);
+	for (unsigned int gate = 0; gate < GATE_COUNT; ++gate) {
+		population.types[gate] = uniform ? logicTypes[gate * logicTypes.size() / GATE_COUNT] : logicTypes[random() % logicTypes.size()];
+		population.masks[gate / STATE_WORD_BITS].setType(gate % STATE_WORD_BITS, population.types[gate]);
+		population.total[gate] = random() % 4;
+		population.powered[gate] = population.total[gate] ? random() % (population.total[gate] + 1) : 0;
+	}
+	return population;
+}
+
+// the per gate type decoding the simulator used before the packed kernels
+void branchyLoop(benchmark::State& state, bool uniform) {
+	GatePopulation population = makePopulation(uniform);
+	for (auto _ : state) {
+		for (unsigned int word = 0; word < WORD_COUNT; ++word) {
+			state_word_t next = 0;
+			for (unsigned int bit = 0; bit < STATE_WORD_BITS; ++bit) {
+				const unsigned int gate = word * STATE_WORD_BITS + bit;
+				const unsigned int type = (unsigned int)population.types[gate];
+				const unsigned int powered = population.powered[gate];
+				const unsigned int total = population.total[gate];
+				bool result;
+				if (type > 7) result = ((type & 1) ^ (powered == total)) && total;
+				else if (type > 5) result = (!((powered & 1) || (powered && (type & 1)))) && total;
+				else if (type > 3) result = (powered & 1) || (powered && (type & 1));
+				else if (type > 1) result = type & 1;
+				else result = (population.current[word] >> bit) & 1;
+				next |= (state_word_t)result << bit;
+			}
+			population.next[word] = next;
+		}
+		benchmark::DoNotOptimize(population.next.data());
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * GATE_COUNT);
+}
+
+void maskKernel(benchmark::State& state, bool uniform) {
+	GatePopulation population = makePopulation(uniform);
+	for (auto _ : state) {
+		for (unsigned int word = 0; word < WORD_COUNT; ++word) {
+			const unsigned int first = word * STATE_WORD_BITS;
+			const GateInputWords inputs = computeInputWords(&population.powered[first], &population.total[first]);
+			population.next[word] = combineGateWord(population.masks[word], inputs, population.current[word]);
+		}
+		benchmark::DoNotOptimize(population.next.data());
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * GATE_COUNT);
+}
+
+void specializedKernel(benchmark::State& state, bool uniform) {
+	GatePopulation population = makePopulation(uniform);
+	for (auto _ : state) {
+		for (unsigned int word = 0; word < WORD_COUNT; ++word) {
+			const unsigned int first = word * STATE_WORD_BITS;
+			population.next[word] = computeGateWord(population.masks[word], &population.powered[first], &population.total[first], population.current[word]);
+		}
+		benchmark::DoNotOptimize(population.next.data());
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * GATE_COUNT);
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(branchyLoop, uniform, true);
+BENCHMARK_CAPTURE(branchyLoop, mixed, false);
+BENCHMARK_CAPTURE(maskKernel, uniform, true);
+BENCHMARK_CAPTURE(maskKernel, mixed, false);
+BENCHMARK_CAPTURE(specializedKernel, uniform, true);
+BENCHMARK_CAPTURE(specializedKernel, mixed, false);
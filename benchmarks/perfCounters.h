@@ -0,0 +1,59 @@
+#ifndef perfCounters_h
+#define perfCounters_h
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Counts last level cache misses of the calling thread with perf_event_open. Not every machine
+// exposes hardware counters (most VMs dont), check isAvailable before reporting anything.
+class CacheMissCounter {
+public:
+	CacheMissCounter() {
+#ifdef __linux__
+		perf_event_attr attributes = {};
+		attributes.type = PERF_TYPE_HARDWARE;
+		attributes.size = sizeof(attributes);
+		attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+		attributes.disabled = 1;
+		attributes.exclude_kernel = 1;
+		attributes.exclude_hv = 1;
+		attributes.inherit = 1; // include the simulation thread started after this
+		fd = syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+#endif
+	}
+	~CacheMissCounter() {
+#ifdef __linux__
+		if (fd >= 0) close(fd);
+#endif
+	}
+	CacheMissCounter(const CacheMissCounter&) = delete;
+	CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+	bool isAvailable() const { return fd >= 0; }
+	void start() {
+#ifdef __linux__
+		if (fd < 0) return;
+		ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+		ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+	}
+	// misses since start
+	unsigned long long stop() {
+		unsigned long long count = 0;
+#ifdef __linux__
+		if (fd < 0) return 0;
+		ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+		if (read(fd, &count, sizeof(count)) != sizeof(count)) count = 0;
+#endif
+		return count;
+	}
+
+private:
+	int fd = -1;
+};
+
+#endif /* perfCounters_h */
@@ -0,0 +1,117 @@
+#include <benchmark/benchmark.h>
+
+#include "workloads.h"
+#include "perfCounters.h"
+
+namespace {
+
+typedef void (*WorkloadBuilder)(LogicSimulator&, unsigned int);
+
+void buildAdders(LogicSimulator& simulator, unsigned int gateCount) { buildRippleCarryAdders(simulator, gateCount); }
+void buildCountersWorkload(LogicSimulator& simulator, unsigned int gateCount) { buildCounters(simulator, gateCount); }
+void buildRings(LogicSimulator& simulator, unsigned int gateCount) { buildRingOscillators(simulator, gateCount); }
+void buildDag(LogicSimulator& simulator, unsigned int gateCount) { buildRandomDag(simulator, gateCount); }
+void buildFanout(LogicSimulator& simulator, unsigned int gateCount) { buildFanoutTrees(simulator, gateCount); }
+
+constexpr unsigned int TICKS_PER_ITERATION = 16;
+
+// args are the gate count, the evaluation mode and the worker count
+void simulateWorkload(benchmark::State& state, WorkloadBuilder build) {
+	LogicSimulator simulator;
+	simulator.setEvaluationMode((EvaluationMode)state.range(1));
+	simulator.setWorkerCount(state.range(2));
+	build(simulator, state.range(0));
+	// compiles the connections and gets past any start up transients
+	simulator.simulateNTicks(TICKS_PER_ITERATION);
+
+	for (auto _ : state) {
+		simulator.simulateNTicks(TICKS_PER_ITERATION);
+	}
+
+	const double ticks = (double)state.iterations() * TICKS_PER_ITERATION;
+	const unsigned int gateCount = simulator.getGateCount();
+	state.counters["ticks/s"] = benchmark::Counter(ticks, benchmark::Counter::kIsRate);
+	// seconds per gate update, shown with an si prefix (n is ns)
+	state.counters["s/gate"] = benchmark::Counter(ticks * gateCount, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+	state.counters["bytes/gate"] = (double)simulator.getMemoryUsage() / gateCount;
+	state.counters["gates"] = gateCount;
+}
+
+void modeArgs(benchmark::internal::Benchmark* benchmark) {
+	benchmark->ArgNames({ "gates", "mode", "workers" });
+	for (int gateCount : { 1 << 12, 1 << 16, 1 << 20 }) {
+		for (EvaluationMode mode : { EvaluationMode::SWEEP, EvaluationMode::EVENT_DRIVEN, EvaluationMode::LEVELIZED }) {
+			benchmark->Args({ gateCount, (int)mode, 1 });
+		}
+	}
+}
+
+void workerArgs(benchmark::internal::Benchmark* benchmark) {
+	benchmark->ArgNames({ "gates", "mode", "workers" });
+	const int maxWorkers = std::max(1u, std::thread::hardware_concurrency());
+	for (int workers = 1; workers <= maxWorkers; workers *= 2) {
+		benchmark->Args({ 1 << 22, (int)EvaluationMode::SWEEP, workers });
+	}
+}
+
+enum class GateOrder {
+	BUILT, // numbered in the order the builder added them
+	SCATTERED, // shuffled like blocks placed all over a big circuit
+	REORDERED, // shuffled and then put back together by the locality pass
+};
+
+// args are the gate count, the evaluation mode and the gate order.
+// the pause wait between ticks is skipped by simulateNTicks so cache misses are all from ticking
+void simulateOrder(benchmark::State& state, WorkloadBuilder build) {
+	LogicSimulator simulator;
+	simulator.setEvaluationMode((EvaluationMode)state.range(1));
+	build(simulator, state.range(0));
+	const GateOrder order = (GateOrder)state.range(2);
+	if (order != GateOrder::BUILT) {
+		std::vector<block_id_t> shuffled(simulator.getGateCount());
+		std::iota(shuffled.begin(), shuffled.end(), 0);
+		std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(1));
+		simulator.reorderGates(shuffled);
+	}
+	if (order == GateOrder::REORDERED) simulator.reorderGates(simulator.getLocalityOrder());
+	simulator.simulateNTicks(TICKS_PER_ITERATION);
+
+	CacheMissCounter cacheMisses;
+	cacheMisses.start();
+	for (auto _ : state) {
+		simulator.simulateNTicks(TICKS_PER_ITERATION);
+	}
+	const unsigned long long misses = cacheMisses.stop();
+
+	const double ticks = (double)state.iterations() * TICKS_PER_ITERATION;
+	state.counters["ticks/s"] = benchmark::Counter(ticks, benchmark::Counter::kIsRate);
+	state.counters["s/gate"] = benchmark::Counter(ticks * simulator.getGateCount(), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+	if (cacheMisses.isAvailable()) state.counters["misses/gate"] = misses / (ticks * simulator.getGateCount());
+}
+
+void orderArgs(benchmark::internal::Benchmark* benchmark) {
+	benchmark->ArgNames({ "gates", "mode", "order" });
+	for (int gateCount : { 1 << 16, 1 << 22 }) {
+		for (EvaluationMode mode : { EvaluationMode::SWEEP, EvaluationMode::EVENT_DRIVEN }) {
+			for (GateOrder order : { GateOrder::BUILT, GateOrder::SCATTERED, GateOrder::REORDERED }) {
+				benchmark->Args({ gateCount, (int)mode, (int)order });
+			}
+		}
+	}
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(simulateWorkload, rippleCarryAdders, buildAdders)->Apply(modeArgs)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(simulateWorkload, counters, buildCountersWorkload)->Apply(modeArgs)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(simulateWorkload, ringOscillators, buildRings)->Apply(modeArgs)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(simulateWorkload, randomDag, buildDag)->Apply(modeArgs)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(simulateWorkload, fanoutTrees, buildFanout)->Apply(modeArgs)->Unit(benchmark::kMicrosecond);
+
+// sweep scaling over the worker pool
+BENCHMARK_CAPTURE(simulateWorkload, ringOscillatorsWorkers, buildRings)->Apply(workerArgs)->Unit(benchmark::kMicrosecond)->UseRealTime();
+BENCHMARK_CAPTURE(simulateWorkload, randomDagWorkers, buildDag)->Apply(workerArgs)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// locality of the gate numbering, misses/gate only shows up where perf_event_open has hardware counters
+BENCHMARK_CAPTURE(simulateOrder, randomDag, buildDag)->Apply(orderArgs)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(simulateOrder, fanoutTrees, buildFanout)->Apply(orderArgs)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,111 @@
+#ifndef workloads_h
+#define workloads_h
+
+#include <random>
+
+#include "backend/evaluator/logicSimulator.h"
+
+// Generated circuits for the benchmarks. Each builds into an empty simulator, keeps adding copies
+// until it has at least gateCount gates and leaves something toggling so the ticks have work to do.
+
+// copies of a ripple carry adder with the carry in of each one fed by a free running clock
+inline void buildRippleCarryAdders(LogicSimulator& simulator, unsigned int gateCount, unsigned int bits = 32) {
+	while (simulator.getGateCount() < gateCount) {
+		const block_id_t clock = simulator.addGate(GateType::NOR);
+		simulator.connectGates(clock, clock);
+		block_id_t carry = clock;
+		for (unsigned int bit = 0; bit < bits; ++bit) {
+			const block_id_t a = simulator.addGate(GateType::DEFAULT_RETURN_CURRENTSTATE);
+			const block_id_t b = simulator.addGate(GateType::DEFAULT_RETURN_CURRENTSTATE);
+			simulator.setState(a, bit % 2);
+			simulator.setState(b, bit % 3 == 0);
+			const block_id_t halfSum = simulator.addGate(GateType::XOR);
+			const block_id_t sum = simulator.addGate(GateType::XOR);
+			const block_id_t generate = simulator.addGate(GateType::AND);
+			const block_id_t propagate = simulator.addGate(GateType::AND);
+			const block_id_t carryOut = simulator.addGate(GateType::OR);
+			simulator.connectGates(a, halfSum);
+			simulator.connectGates(b, halfSum);
+			simulator.connectGates(halfSum, sum);
+			simulator.connectGates(carry, sum);
+			simulator.connectGates(a, generate);
+			simulator.connectGates(b, generate);
+			simulator.connectGates(halfSum, propagate);
+			simulator.connectGates(carry, propagate);
+			simulator.connectGates(generate, carryOut);
+			simulator.connectGates(propagate, carryOut);
+			carry = carryOut;
+		}
+	}
+}
+
+// binary counters, each bit is an xor holding its own state that flips when the carry into it is on
+inline void buildCounters(LogicSimulator& simulator, unsigned int gateCount, unsigned int bits = 32) {
+	while (simulator.getGateCount() < gateCount) {
+		block_id_t carry = simulator.addGate(GateType::CONSTANT_ON);
+		for (unsigned int bit = 0; bit < bits; ++bit) {
+			const block_id_t state = simulator.addGate(GateType::XOR);
+			simulator.connectGates(state, state);
+			simulator.connectGates(carry, state);
+			const block_id_t carryOut = simulator.addGate(GateType::AND);
+			simulator.connectGates(state, carryOut);
+			simulator.connectGates(carry, carryOut);
+			carry = carryOut;
+		}
+	}
+}
+
+// rings of an odd number of inverters, every gate changes every tick
+inline void buildRingOscillators(LogicSimulator& simulator, unsigned int gateCount, unsigned int ringSize = 1023) {
+	while (simulator.getGateCount() < gateCount) {
+		const block_id_t first = simulator.addGate(GateType::NOR);
+		block_id_t last = first;
+		for (unsigned int i = 1; i < ringSize; ++i) {
+			const block_id_t gate = simulator.addGate(GateType::NOR);
+			simulator.connectGates(last, gate);
+			last = gate;
+		}
+		simulator.connectGates(last, first);
+	}
+}
+
+// random logic where every gate only reads from gates added before it, driven by a few clocks
+inline void buildRandomDag(LogicSimulator& simulator, unsigned int gateCount, unsigned int inputsPerGate = 3, unsigned int seed = 1) {
+	const std::vector<GateType> types = { GateType::AND, GateType::OR, GateType::XOR, GateType::NAND, GateType::NOR, GateType::XNOR };
+	std::mt19937 random(seed);
+	for (unsigned int i = 0; i < 64; ++i) {
+		const block_id_t clock = simulator.addGate(GateType::NOR);
+		simulator.connectGates(clock, clock);
+	}
+	const unsigned int firstLogic = simulator.getGateCount();
+	while (simulator.getGateCount() < gateCount) {
+		const block_id_t gate = simulator.addGate(types[random() % types.size()]);
+		for (unsigned int i = 0; i < inputsPerGate; ++i) {
+			// mostly recent gates so the logic gets deep instead of flat
+			const unsigned int window = std::min<unsigned int>(gate, 256);
+			const block_id_t input = random() % 4 == 0 ? random() % firstLogic : gate - 1 - random() % window;
+			simulator.connectGates(input, gate);
+		}
+	}
+}
+
+// one clock driving trees of buffers that each fan out to fanout more
+inline void buildFanoutTrees(LogicSimulator& simulator, unsigned int gateCount, unsigned int fanout = 64) {
+	const block_id_t clock = simulator.addGate(GateType::NOR);
+	simulator.connectGates(clock, clock);
+	std::vector<block_id_t> level = { clock };
+	std::vector<block_id_t> nextLevel;
+	while (simulator.getGateCount() < gateCount) {
+		nextLevel.clear();
+		for (block_id_t driver : level) {
+			for (unsigned int i = 0; i < fanout && simulator.getGateCount() < gateCount; ++i) {
+				const block_id_t buffer = simulator.addGate(GateType::OR);
+				simulator.connectGates(driver, buffer);
+				nextLevel.push_back(buffer);
+			}
+		}
+		level.swap(nextLevel);
+	}
+}
+
+#endif /* workloads_h */
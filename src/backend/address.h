@@ -3,17 +3,18 @@
 
 #include "position/position.h"
 
+// The first position is stored inline so addresses in the top circuit never allocate.
 class Address {
 public:
-	Address(Position position) : addresses({ position }) { }
-	inline int size() const { return addresses.size(); }
-	inline Position getPosition(int index) const { return addresses[index]; }
+	Address(Position position) : first(position) { }
+	inline int size() const { return 1 + nested.size(); }
+	inline Position getPosition(int index) const { return index == 0 ? first : nested[index - 1]; }
 
-	inline void addBlockId(Position position) { addresses.push_back(position); }
+	inline void addBlockId(Position position) { nested.push_back(position); }
 
 private:
-	std::vector<Position> addresses;
-
+	Position first;
+	std::vector<Position> nested; // positions inside sub circuits, empty vectors dont allocate
 };
 
 #endif /* address_h */
@@ -1,30 +1,32 @@
 #include "circuit.h"
 
 bool Circuit::tryInsertBlock(const Position& position, Rotation rotation, BlockType blockType) {
-	DifferenceSharedPtr difference = std::make_shared<Difference>();
+	DifferenceSharedPtr difference = startDifference();
 	bool out = blockContainer.tryInsertBlock(position, rotation, blockType, difference.get());
 	sendDifference(difference);
 	return out;
 }
 
 bool Circuit::tryRemoveBlock(const Position& position) {
-	DifferenceSharedPtr difference = std::make_shared<Difference>();
+	DifferenceSharedPtr difference = startDifference();
 	bool out = blockContainer.tryRemoveBlock(position, difference.get());
 	sendDifference(difference);
 	return out;
 }
 
 bool Circuit::tryMoveBlock(const Position& positionOfBlock, const Position& position) {
-	DifferenceSharedPtr difference = std::make_shared<Difference>();
+	DifferenceSharedPtr difference = startDifference();
+	// the transaction difference can already hold earlier edits
+	[[maybe_unused]] const unsigned int modificationCount = difference->size();
 	bool out = blockContainer.tryMoveBlock(positionOfBlock, position, difference.get());
-	assert(out != difference->empty());
+	assert(out == (difference->size() != modificationCount));
 	sendDifference(difference);
 	return out;
 }
 
 bool Circuit::tryMoveBlocks(const SharedSelection& selection, const Vector& movement) {
 	if (checkMoveCollision(selection, movement)) return false;
-	DifferenceSharedPtr difference = std::make_shared<Difference>();
+	DifferenceSharedPtr difference = startDifference();
 	moveBlocks(selection, movement, difference.get());
 	sendDifference(difference);
 	return true;
@@ -66,30 +68,24 @@ bool Circuit::checkMoveCollision(const SharedSelection& selection, const Vector&
 	return false;
 }
 
-void Circuit::tryInsertOverArea(Position cellA, Position cellB, Rotation rotation, BlockType blockType) {
+unsigned int Circuit::tryInsertOverArea(Position cellA, Position cellB, Rotation rotation, BlockType blockType) {
 	if (cellA.x > cellB.x) std::swap(cellA.x, cellB.x);
 	if (cellA.y > cellB.y) std::swap(cellA.y, cellB.y);
 
-	DifferenceSharedPtr difference = std::make_shared<Difference>();
-	for (cord_t x = cellA.x; x <= cellB.x; x++) {
-		for (cord_t y = cellA.y; y <= cellB.y; y++) {
-			blockContainer.tryInsertBlock(Position(x, y), rotation, blockType, difference.get());
-		}
-	}
+	DifferenceSharedPtr difference = startDifference();
+	unsigned int placed = blockContainer.tryInsertOverArea(cellA, cellB, rotation, blockType, difference.get());
 	sendDifference(difference);
+	return placed;
 }
 
-void Circuit::tryRemoveOverArea(Position cellA, Position cellB) {
+unsigned int Circuit::tryRemoveOverArea(Position cellA, Position cellB) {
 	if (cellA.x > cellB.x) std::swap(cellA.x, cellB.x);
 	if (cellA.y > cellB.y) std::swap(cellA.y, cellB.y);
 
-	DifferenceSharedPtr difference = std::make_shared<Difference>();
-	for (cord_t x = cellA.x; x <= cellB.x; x++) {
-		for (cord_t y = cellA.y; y <= cellB.y; y++) {
-			blockContainer.tryRemoveBlock(Position(x, y), difference.get());
-		}
-	}
+	DifferenceSharedPtr difference = startDifference();
+	unsigned int removed = blockContainer.tryRemoveOverArea(cellA, cellB, difference.get());
 	sendDifference(difference);
+	return removed;
 }
 
 bool Circuit::checkCollision(const SharedSelection& selection) {
@@ -110,21 +106,21 @@ bool Circuit::checkCollision(const SharedSelection& selection) {
 }
 
 bool Circuit::trySetBlockData(const Position& positionOfBlock, block_data_t data) {
-	DifferenceSharedPtr difference = std::make_shared<Difference>();
+	DifferenceSharedPtr difference = startDifference();
 	bool out = blockContainer.trySetBlockData(positionOfBlock, data, difference.get());
 	sendDifference(difference);
 	return out;
 }
 
 bool Circuit::tryCreateConnection(const Position& outputPosition, const Position& inputPosition) {
-	DifferenceSharedPtr difference = std::make_shared<Difference>();
+	DifferenceSharedPtr difference = startDifference();
 	bool out = blockContainer.tryCreateConnection(outputPosition, inputPosition, difference.get());
 	sendDifference(difference);
 	return out;
 }
 
 bool Circuit::tryRemoveConnection(const Position& outputPosition, const Position& inputPosition) {
-	DifferenceSharedPtr difference = std::make_shared<Difference>();
+	DifferenceSharedPtr difference = startDifference();
 	bool out = blockContainer.tryRemoveConnection(outputPosition, inputPosition, difference.get());
 	sendDifference(difference);
 	return out;
@@ -132,7 +128,7 @@ bool Circuit::tryRemoveConnection(const Position& outputPosition, const Position
 
 bool Circuit::tryCreateConnection(SharedSelection outputSelection, SharedSelection inputSelection) {
 	if (!sameSelectionShape(outputSelection, inputSelection)) return false;
-	DifferenceSharedPtr difference = std::make_shared<Difference>();
+	DifferenceSharedPtr difference = startDifference();
 	createConnection(outputSelection, inputSelection, difference.get());
 	sendDifference(difference);
 	return true;
@@ -140,7 +136,7 @@ bool Circuit::tryCreateConnection(SharedSelection outputSelection, SharedSelecti
 
 bool Circuit::tryRemoveConnection(SharedSelection outputSelection, SharedSelection inputSelection) {
 	if (!sameSelectionShape(outputSelection, inputSelection)) return false;
-	DifferenceSharedPtr difference = std::make_shared<Difference>();
+	DifferenceSharedPtr difference = startDifference();
 	removeConnection(outputSelection, inputSelection, difference.get());
 	sendDifference(difference);
 	return true;
@@ -202,47 +198,76 @@ void Circuit::removeConnection(SharedSelection outputSelection, SharedSelection
 	}
 }
 
-void Circuit::undo() {
-	startUndo();
-	DifferenceSharedPtr newDifference = std::make_shared<Difference>();
-	DifferenceSharedPtr difference = undoSystem.undoDifference();
+void Circuit::beginTransaction(unsigned int expectedModifications) {
+	if (transactionDifference) throw std::logic_error("Circuit::beginTransaction: already in a transaction");
+	transactionDifference = std::make_shared<Difference>();
+	transactionDifference->reserve(expectedModifications);
+	blockContainer.reserveBlocks(expectedModifications);
+}
+
+void Circuit::commitTransaction() {
+	if (!transactionDifference) throw std::logic_error("Circuit::commitTransaction: not in a transaction");
+	DifferenceSharedPtr difference = transactionDifference;
+	transactionDifference = nullptr;
+	sendDifference(difference);
+}
+
+void Circuit::abortTransaction() {
+	if (!transactionDifference) throw std::logic_error("Circuit::abortTransaction: not in a transaction");
+	DifferenceSharedPtr difference = transactionDifference;
+	transactionDifference = nullptr;
+	// nobody saw the edits so the revert is not sent either
+	Difference revertedDifference;
+	revertDifference(difference, &revertedDifference);
+}
+
+void Circuit::revertDifference(DifferenceSharedPtr difference, Difference* newDifference) {
 	Difference::block_modification_t blockModification;
 	Difference::connection_modification_t connectionModification;
 	Difference::data_modification_t dataModification;
-	const std::vector<Difference::Modification>& modifications = difference->getModifications();
-	for (unsigned int i = modifications.size(); i > 0; --i) {
-		const Difference::Modification& modification = modifications[i - 1];
+	const Difference::ModificationView modifications = difference->getModifications();
+	// stepping the iterator back by hand decodes each modification once, a reverse_iterator would do it twice
+	for (auto iter = modifications.end(); iter != modifications.begin();) {
+		const Difference::Modification modification = *(--iter);
 		switch (modification.first) {
 		case Difference::PLACE_BLOCK:
-			blockContainer.tryRemoveBlock(std::get<0>(std::get<Difference::block_modification_t>(modification.second)), newDifference.get());
+			blockContainer.tryRemoveBlock(std::get<0>(std::get<Difference::block_modification_t>(modification.second)), newDifference);
 			break;
 		case Difference::REMOVED_BLOCK:
 			blockModification = std::get<Difference::block_modification_t>(modification.second);
-			blockContainer.tryInsertBlock(std::get<0>(blockModification), std::get<1>(blockModification), std::get<2>(blockModification), newDifference.get());
+			blockContainer.tryInsertBlock(std::get<0>(blockModification), std::get<1>(blockModification), std::get<2>(blockModification), newDifference);
 			break;
 		case Difference::CREATED_CONNECTION:
 			connectionModification = std::get<Difference::connection_modification_t>(modification.second);
-			blockContainer.tryRemoveConnection(std::get<0>(connectionModification), std::get<1>(connectionModification), newDifference.get());
+			blockContainer.tryRemoveConnection(std::get<0>(connectionModification), std::get<1>(connectionModification), newDifference);
 			break;
 		case Difference::REMOVED_CONNECTION:
 			connectionModification = std::get<Difference::connection_modification_t>(modification.second);
-			blockContainer.tryCreateConnection(std::get<0>(connectionModification), std::get<1>(connectionModification), newDifference.get());
+			blockContainer.tryCreateConnection(std::get<0>(connectionModification), std::get<1>(connectionModification), newDifference);
 			break;
 		case Difference::MOVE_BLOCK:
 			connectionModification = std::get<Difference::move_modification_t>(modification.second);
-			blockContainer.tryMoveBlock(std::get<1>(connectionModification), std::get<0>(connectionModification), newDifference.get());
+			blockContainer.tryMoveBlock(std::get<1>(connectionModification), std::get<0>(connectionModification), newDifference);
 			break;
 		case Difference::SET_DATA:
 			dataModification = std::get<Difference::data_modification_t>(modification.second);
-			blockContainer.trySetBlockData(std::get<0>(dataModification), std::get<2>(dataModification), newDifference.get());
+			blockContainer.trySetBlockData(std::get<0>(dataModification), std::get<2>(dataModification), newDifference);
 			break;
 		}
 	}
+}
+
+void Circuit::undo() {
+	if (transactionDifference) throw std::logic_error("Circuit::undo: can not undo during a transaction");
+	startUndo();
+	DifferenceSharedPtr newDifference = std::make_shared<Difference>();
+	revertDifference(undoSystem.undoDifference(), newDifference.get());
 	sendDifference(newDifference);
 	endUndo();
 }
 
 void Circuit::redo() {
+	if (transactionDifference) throw std::logic_error("Circuit::redo: can not redo during a transaction");
 	startUndo();
 	DifferenceSharedPtr newDifference = std::make_shared<Difference>();
 	DifferenceSharedPtr difference = undoSystem.redoDifference();
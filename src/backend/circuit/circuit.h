@@ -41,8 +41,10 @@ public:
 	// Trys to move a blocks. Wont move any if one cant move. Returns if successful.
 	bool tryMoveBlocks(const SharedSelection& selection, const Vector& movement);
 
-	void tryInsertOverArea(Position cellA, Position cellB, Rotation rotation, BlockType blockType);
-	void tryRemoveOverArea(Position cellA, Position cellB);
+	// Places blocks where they fit. Returns the number placed.
+	unsigned int tryInsertOverArea(Position cellA, Position cellB, Rotation rotation, BlockType blockType);
+	// Removes every block with a cell in the area. Returns the number removed.
+	unsigned int tryRemoveOverArea(Position cellA, Position cellB);
 
 	bool checkCollision(const SharedSelection& selection);
 
@@ -53,7 +55,7 @@ public:
 	// Sets the data value to a block at position. Returns if block found.
 	template<class T, unsigned int index>
 	bool trySetBlockDataValue(const Position& positionOfBlock, T value) {
-		DifferenceSharedPtr difference = std::make_shared<Difference>();
+		DifferenceSharedPtr difference = startDifference();
 		bool out = blockContainer.trySetBlockDataValue<T, index>(positionOfBlock, value, difference.get());
 		sendDifference(difference);
 		return out;
@@ -70,7 +72,18 @@ public:
 	bool tryRemoveConnection(SharedSelection outputSelection, SharedSelection inputSelection);
 
 
+	/* ----------- transactions ----------- */
+	// Edits made between begin and commit go to listeners and the undo history as one Difference.
+	// Abort puts the circuit back the way it was without listeners ever seeing the edits.
+	// expectedModifications reserves room for that many blocks and modifications up front.
+	// Throws std::logic_error when beginning twice, or committing or aborting without beginning
+	void beginTransaction(unsigned int expectedModifications = 0);
+	void commitTransaction();
+	void abortTransaction();
+	inline bool inTransaction() const { return transactionDifference != nullptr; }
+
 	/* ----------- undo ----------- */
+	// Throws std::logic_error during a transaction
 	void undo();
 	void redo();
 
@@ -82,16 +95,23 @@ private:
 	void createConnection(SharedSelection outputSelection, SharedSelection inputSelection, Difference* difference);
 	void removeConnection(SharedSelection outputSelection, SharedSelection inputSelection, Difference* difference);
 
+	// applies the opposite of every modification in reverse order
+	void revertDifference(DifferenceSharedPtr difference, Difference* newDifference);
+
 	void startUndo() { midUndo = true; }
 	void endUndo() { midUndo = false; }
 
-	void sendDifference(DifferenceSharedPtr difference) { if (difference->empty()) return; if (!midUndo) undoSystem.addDifference(difference); for (auto pair : listenerFunctions) pair.second(difference, circuitId); }
+	// edits during a transaction all go into its difference
+	DifferenceSharedPtr startDifference() { return transactionDifference ? transactionDifference : std::make_shared<Difference>(); }
+	// does nothing for the transaction difference until it is committed
+	void sendDifference(DifferenceSharedPtr difference) { if (difference->empty() || difference == transactionDifference) return; if (!midUndo) undoSystem.addDifference(difference); for (auto pair : listenerFunctions) pair.second(difference, circuitId); }
 
 	circuit_id_t circuitId;
 	BlockContainer blockContainer;
 	std::map<void*, ListenerFunction> listenerFunctions;
 	UndoSystem undoSystem;
 	bool midUndo = false;
+	DifferenceSharedPtr transactionDifference;
 	unsigned int updateCount = 0; // increases anytime the container is changed
 };
 
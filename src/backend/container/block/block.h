@@ -68,7 +68,7 @@ protected:
 	inline void setId(block_id_t id) { blockId = id; }
 
 	inline Block(BlockType blockType) : Block(blockType, 0) { }
-	inline Block(BlockType blockType, block_id_t id) : blockType(blockType), blockId(id), connections(blockType), position(), rotation() { }
+	inline Block(BlockType blockType, block_id_t id) : blockType(blockType), blockId(id), connections(blockType), position(), rotation(), data(0) { }
 
 	// const data
 	BlockType blockType;
@@ -1,9 +1,13 @@
+#include <cassert>
+
 #include "../blockContainer.h"
 #include "util/algorithm.h"
 #include "connectionContainer.h"
 #include "block.h"
 
-ConnectionContainer::ConnectionContainer(BlockType blockType) : blockType(blockType), connections(::getMaxConnectionId(blockType) + 1) { }
+ConnectionContainer::ConnectionContainer(BlockType blockType) : blockType(blockType), endCount(::getMaxConnectionId(blockType) + 1), connections() {
+	assert(endCount <= MAX_END_COUNT);
+}
 
 bool ConnectionContainer::tryMakeConnection(connection_end_id_t thisEndId, const ConnectionEnd& otherConnectionEnd) {
 	// not a valid Id
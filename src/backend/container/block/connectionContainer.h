@@ -1,6 +1,8 @@
 #ifndef connectionContainer_h
 #define connectionContainer_h
 
+#include <array>
+
 #include "util/emptyVector.h"
 #include "connectionEnd.h"
 #include "blockDefs.h"
@@ -9,11 +11,15 @@ class BlockContainer;
 class ConnectionContainer {
 	friend BlockContainer;
 public:
+	// every block type has at most this many connection ends, they are stored inline so a block without
+	// connections costs no allocations
+	static constexpr unsigned int MAX_END_COUNT = 2;
+
 	ConnectionContainer(BlockType blockType);
 
 	BlockType getBlockType() const { return blockType; }
 
-	inline connection_end_id_t getMaxConnectionId() const { return connections.size() - 1; }
+	inline connection_end_id_t getMaxConnectionId() const { return endCount - 1; }
 
 	inline const std::vector<ConnectionEnd>& getConnections(connection_end_id_t thisEndId) const {
 		if (thisEndId > getMaxConnectionId()) return getEmptyVector<ConnectionEnd>(); return connections[thisEndId];
@@ -26,7 +32,8 @@ private:
 	bool tryRemoveConnection(connection_end_id_t thisEndId, const ConnectionEnd& otherConnectionEnd);
 
 	BlockType blockType;
-	std::vector<std::vector<ConnectionEnd>> connections;
+	unsigned char endCount;
+	std::array<std::vector<ConnectionEnd>, MAX_END_COUNT> connections;
 };
 
 #endif /* connectionContainer_h */
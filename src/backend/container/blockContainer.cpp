@@ -5,12 +5,7 @@
 #include "block/block.h"
 
 bool BlockContainer::checkCollision(const Position& positionSmall, const Position& positionLarge) {
-	for (cord_t x = positionSmall.x; x <= positionLarge.x; x++) {
-		for (cord_t y = positionSmall.y; y <= positionLarge.y; y++) {
-			if (checkCollision(Position(x, y))) return true;
-		}
-	}
-	return false;
+	return grid.anyInArea(positionSmall, positionLarge);
 }
 
 bool BlockContainer::tryInsertBlock(const Position& position, Rotation rotation, BlockType blockType) {
@@ -19,20 +14,18 @@ bool BlockContainer::tryInsertBlock(const Position& position, Rotation rotation,
 		blockType == BlockType::TYPE_COUNT ||
 		checkCollision(position, position + Vector(getBlockWidth(blockType, rotation) - 1, getBlockHeight(blockType, rotation) - 1))
 		) return false;
-	block_id_t id = getNewId();
-	auto iter = blocks.insert(std::make_pair(id, getBlockClass(blockType))).first;
-	iter->second.setId(id);
-	iter->second.setPosition(position);
-	iter->second.setRotation(rotation);
-	placeBlockCells(&iter->second);
+	Block& block = addBlock(blockType);
+	block.setPosition(position);
+	block.setRotation(rotation);
+	placeBlockCells(&block);
 	return true;
 }
 
 bool BlockContainer::tryRemoveBlock(const Position& position) {
 	Cell* cell = getCell(position);
 	if (cell == nullptr) return false;
-	auto iter = blocks.find(cell->getBlockId());
-	Block& block = iter->second;
+	Block& block = *getBlock(cell->getBlockId());
+	indexBlockConnections(&block, false);
 	removeBlockCells(&block);
 	// make sure to remove all connections from this block
 	for (unsigned int i = 0; i <= block.getConnectionContainer().getMaxConnectionId(); i++) {
@@ -42,7 +35,7 @@ bool BlockContainer::tryRemoveBlock(const Position& position) {
 		}
 	}
 	block.destroy();
-	blocks.erase(iter);
+	eraseBlock(block.id());
 	return true;
 }
 
@@ -58,9 +51,11 @@ bool BlockContainer::tryMoveBlock(const Position& positionOfBlock, const Positio
 			)
 		)
 		) return false;
+	indexBlockConnections(block, false);
 	removeBlockCells(block);
 	block->setPosition(position);
 	placeBlockCells(block);
+	indexBlockConnections(block, true);
 	return true;
 }
 
@@ -70,12 +65,10 @@ bool BlockContainer::tryInsertBlock(const Position& position, Rotation rotation,
 		blockType == BlockType::TYPE_COUNT ||
 		checkCollision(position, position + Vector(getBlockWidth(blockType, rotation) - 1, getBlockHeight(blockType, rotation) - 1))
 		) return false;
-	block_id_t id = getNewId();
-	auto iter = blocks.insert(std::make_pair(id, getBlockClass(blockType))).first;
-	iter->second.setId(id);
-	iter->second.setPosition(position);
-	iter->second.setRotation(rotation);
-	placeBlockCells(&iter->second);
+	Block& block = addBlock(blockType);
+	block.setPosition(position);
+	block.setRotation(rotation);
+	placeBlockCells(&block);
 	difference->addPlacedBlock(position, rotation, blockType);
 	return true;
 }
@@ -83,8 +76,8 @@ bool BlockContainer::tryInsertBlock(const Position& position, Rotation rotation,
 bool BlockContainer::tryRemoveBlock(const Position& position, Difference* difference) {
 	Cell* cell = getCell(position);
 	if (cell == nullptr) return false;
-	auto iter = blocks.find(cell->getBlockId());
-	Block& block = iter->second;
+	Block& block = *getBlock(cell->getBlockId());
+	indexBlockConnections(&block, false);
 	removeBlockCells(&block);
 	// make sure to remove all connections from this block
 	for (unsigned int i = 0; i <= block.getConnectionContainer().getMaxConnectionId(); i++) {
@@ -104,7 +97,7 @@ bool BlockContainer::tryRemoveBlock(const Position& position, Difference* differ
 	}
 	difference->addRemovedBlock(block.getPosition(), block.getRotation(), block.type());
 	block.destroy();
-	blocks.erase(iter);
+	eraseBlock(block.id());
 	return true;
 }
 
@@ -125,12 +118,66 @@ bool BlockContainer::tryMoveBlock(const Position& positionOfBlock, const Positio
 
 	// do move
 	difference->addMovedBlock(block->getPosition(), position);
+	indexBlockConnections(block, false);
 	removeBlockCells(block);
 	block->setPosition(position);
 	placeBlockCells(block);
+	indexBlockConnections(block, true);
 	return true;
 }
 
+unsigned int BlockContainer::tryInsertOverArea(const Position& small, const Position& large, Rotation rotation, BlockType blockType, Difference* difference) {
+	if (blockType == BlockType::NONE || blockType == BlockType::TYPE_COUNT || small.x > large.x || small.y > large.y) return 0;
+	const block_size_t width = getBlockWidth(blockType, rotation);
+	const block_size_t height = getBlockHeight(blockType, rotation);
+	// blocks at the far edge can stick out of the area
+	if (checkCollision(small, large + Vector(width - 1, height - 1))) {
+		unsigned int placed = 0;
+		for (cord_t x = small.x; x <= large.x; x++) {
+			for (cord_t y = small.y; y <= large.y; y++) {
+				placed += tryInsertBlock(Position(x, y), rotation, blockType, difference);
+			}
+		}
+		return placed;
+	}
+	// nothing in the way so every block lands where the cell by cell loop would put it
+	const unsigned int columns = (large.x - small.x) / width + 1;
+	const unsigned int rows = (large.y - small.y) / height + 1;
+	reserveBlocks(columns * rows);
+	for (cord_t x = small.x; x <= large.x; x += width) {
+		for (cord_t y = small.y; y <= large.y; y += height) {
+			Block& block = addBlock(blockType);
+			block.setPosition(Position(x, y));
+			block.setRotation(rotation);
+			placeBlockCells(&block);
+			difference->addPlacedBlock(Position(x, y), rotation, blockType);
+		}
+	}
+	return columns * rows;
+}
+
+unsigned int BlockContainer::tryRemoveOverArea(const Position& small, const Position& large, Difference* difference) {
+	// the index finds the blocks so empty parts of the area cost nothing
+	std::vector<Position> positions;
+	blockIndex.forEachInArea(small, large, [&](block_id_t blockId) {
+		positions.push_back(getBlock(blockId)->getPosition());
+	});
+	for (const Position& position : positions) {
+		tryRemoveBlock(position, difference);
+	}
+	return positions.size();
+}
+
+void BlockContainer::reserveBlocks(unsigned int blockCount) {
+	if (blockCount <= freeBlockSlots.size()) return;
+	// keep growing by doubling so many small reserves stay linear
+	const size_t slotCount = slotGenerations.size() + blockCount - freeBlockSlots.size();
+	if (slotCount > slotGenerations.capacity()) slotGenerations.reserve(std::max<size_t>(slotCount, slotGenerations.capacity() * 2));
+	while (blockChunks.size() << BLOCK_CHUNK_BITS < slotCount) {
+		blockChunks.push_back(std::make_unique<Block[]>(BLOCK_CHUNK_MASK + 1));
+	}
+}
+
 // block_data_t BlockContainer::getBlockData(const Position& positionOfBlock) const {
 //     Block* block = getBlock(positionOfBlock);
 //     if (!block) return 0;
@@ -205,6 +252,7 @@ bool BlockContainer::tryCreateConnection(const Position& outputPosition, const P
 	if (!outputSuccess) return false;
 	if (input->getConnectionContainer().tryMakeConnection(inputConnectionId, ConnectionEnd(output->id(), outputConnectionId))) {
 		assert(output->getConnectionContainer().tryMakeConnection(outputConnectionId, ConnectionEnd(input->id(), inputConnectionId)));
+		indexConnection(ConnectionEnd(output->id(), outputConnectionId), ConnectionEnd(input->id(), inputConnectionId), true);
 		return true;
 	}
 	return false;
@@ -221,6 +269,7 @@ bool BlockContainer::tryRemoveConnection(const Position& outputPosition, const P
 	if (!outputSuccess) return false;
 	if (input->getConnectionContainer().tryRemoveConnection(inputConnectionId, ConnectionEnd(output->id(), outputConnectionId))) {
 		assert(output->getConnectionContainer().tryRemoveConnection(outputConnectionId, ConnectionEnd(input->id(), inputConnectionId)));
+		indexConnection(ConnectionEnd(output->id(), outputConnectionId), ConnectionEnd(input->id(), inputConnectionId), false);
 		return true;
 	}
 	return false;
@@ -237,6 +286,7 @@ bool BlockContainer::tryCreateConnection(const Position& outputPosition, const P
 	if (!outputSuccess) return false;
 	if (input->getConnectionContainer().tryMakeConnection(inputConnectionId, ConnectionEnd(output->id(), outputConnectionId))) {
 		assert(output->getConnectionContainer().tryMakeConnection(outputConnectionId, ConnectionEnd(input->id(), inputConnectionId)));
+		indexConnection(ConnectionEnd(output->id(), outputConnectionId), ConnectionEnd(input->id(), inputConnectionId), true);
 		difference->addCreatedConnection(outputPosition, inputPosition);
 		return true;
 	}
@@ -254,6 +304,7 @@ bool BlockContainer::tryRemoveConnection(const Position& outputPosition, const P
 	if (!outputSuccess) return false;
 	if (input->getConnectionContainer().tryRemoveConnection(inputConnectionId, ConnectionEnd(output->id(), outputConnectionId))) {
 		assert(output->getConnectionContainer().tryRemoveConnection(outputConnectionId, ConnectionEnd(input->id(), inputConnectionId)));
+		indexConnection(ConnectionEnd(output->id(), outputConnectionId), ConnectionEnd(input->id(), inputConnectionId), false);
 		difference->addRemovedConnection(outputPosition, inputPosition);
 		return true;
 	}
@@ -261,39 +312,102 @@ bool BlockContainer::tryRemoveConnection(const Position& outputPosition, const P
 }
 
 void BlockContainer::placeBlockCells(const Position& position, Rotation rotation, BlockType type, block_id_t blockId) {
-	for (cord_t x = 0; x < getBlockWidth(type, rotation); x++) {
-		for (cord_t y = 0; y < getBlockHeight(type, rotation); y++) {
-			insertCell(position + Vector(x, y), Cell(blockId));
-		}
-	}
+	const Position largest = position + Vector(getBlockWidth(type, rotation) - 1, getBlockHeight(type, rotation) - 1);
+	grid.insertArea(position, largest, Cell(blockId));
+	blockIndex.insert(position, largest, blockId);
 }
 
 void BlockContainer::placeBlockCells(const Block* block) {
-	for (cord_t x = 0; x < block->width(); x++) {
-		for (cord_t y = 0; y < block->height(); y++) {
-			insertCell(block->getPosition() + Vector(x, y), Cell(block->id()));
-		}
-	}
+	const Position largest = block->getPosition() + Vector(block->width() - 1, block->height() - 1);
+	grid.insertArea(block->getPosition(), largest, Cell(block->id()));
+	blockIndex.insert(block->getPosition(), largest, block->id());
 }
 
 void BlockContainer::removeBlockCells(const Block* block) {
-	for (cord_t x = 0; x < block->width(); x++) {
-		for (cord_t y = 0; y < block->height(); y++) {
-			removeCell(block->getPosition() + Vector(x, y));
+	const Position largest = block->getPosition() + Vector(block->width() - 1, block->height() - 1);
+	grid.removeArea(block->getPosition(), largest);
+	blockIndex.remove(block->getPosition(), largest, block->id());
+}
+
+Block& BlockContainer::addBlock(BlockType blockType) {
+	unsigned int slot;
+	if (freeBlockSlots.empty()) {
+		slot = slotGenerations.size();
+		if (slot > BLOCK_SLOT_MASK) throw std::out_of_range("BlockContainer::addBlock: too many blocks");
+		if (slot >> BLOCK_CHUNK_BITS == blockChunks.size()) blockChunks.push_back(std::make_unique<Block[]>(BLOCK_CHUNK_MASK + 1));
+		slotGenerations.push_back(1);
+	} else {
+		slot = freeBlockSlots.back();
+		freeBlockSlots.pop_back();
+	}
+	++blockCount;
+	Block& block = blockAt(slot);
+	block = getBlockClass(blockType);
+	block.setId(slot | (slotGenerations[slot] << BLOCK_SLOT_BITS));
+	return block;
+}
+
+void BlockContainer::eraseBlock(block_id_t blockId) {
+	const unsigned int slot = blockId & BLOCK_SLOT_MASK;
+	// the other blocks stay where they are, the slot keeps a NONE block until it is reused
+	blockAt(slot) = Block(BlockType::NONE);
+	--blockCount;
+	if (slotGenerations[slot] + 1 < BLOCK_GENERATION_COUNT) {
+		++slotGenerations[slot];
+		freeBlockSlots.push_back(slot);
+	} else {
+		// every generation was handed out, reusing the slot would let an old id find the new block
+		slotGenerations[slot] = 0;
+	}
+}
+
+void BlockContainer::indexConnection(const ConnectionEnd& outputEnd, const ConnectionEnd& inputEnd, bool add) {
+	const Position outputPosition = getBlock(outputEnd.getBlockId())->getConnectionPosition(outputEnd.getConnectionId()).first;
+	const Position inputPosition = getBlock(inputEnd.getBlockId())->getConnectionPosition(inputEnd.getConnectionId()).first;
+	const Position small(std::min(outputPosition.x, inputPosition.x), std::min(outputPosition.y, inputPosition.y));
+	const Position large(std::max(outputPosition.x, inputPosition.x), std::max(outputPosition.y, inputPosition.y));
+	if (add) connectionIndex.insert(small, large, { outputEnd, inputEnd });
+	else connectionIndex.remove(small, large, { outputEnd, inputEnd });
+}
+
+void BlockContainer::indexBlockConnections(const Block* block, bool add) {
+	for (connection_end_id_t id = 0; id <= block->getConnectionContainer().getMaxConnectionId(); id++) {
+		const bool input = block->isConnectionInput(id);
+		for (const ConnectionEnd& otherEnd : block->getConnectionContainer().getConnections(id)) {
+			// connections to itself are seen from both ends, only do them once from the output
+			if (input && otherEnd.getBlockId() == block->id()) continue;
+			if (input) indexConnection(otherEnd, ConnectionEnd(block->id(), id), add);
+			else indexConnection(ConnectionEnd(block->id(), id), otherEnd, add);
 		}
 	}
 }
 
+std::vector<const Block*> BlockContainer::getBlocksInArea(const Position& small, const Position& large) const {
+	std::vector<const Block*> foundBlocks;
+	blockIndex.forEachInArea(small, large, [&](block_id_t blockId) {
+		foundBlocks.push_back(getBlock(blockId));
+	});
+	return foundBlocks;
+}
+
+std::vector<std::pair<ConnectionEnd, ConnectionEnd>> BlockContainer::getConnectionsInArea(const Position& small, const Position& large) const {
+	std::vector<std::pair<ConnectionEnd, ConnectionEnd>> connections;
+	connectionIndex.forEachInArea(small, large, [&](const std::pair<ConnectionEnd, ConnectionEnd>& connection) {
+		connections.push_back(connection);
+	});
+	return connections;
+}
+
 Difference BlockContainer::getCreationDifference() const {
 	Difference difference;
-	for (auto iter : blocks) {
-		difference.addPlacedBlock(iter.second.getPosition(), iter.second.getRotation(), iter.second.type());
+	for (const Block& block : *this) {
+		difference.addPlacedBlock(block.getPosition(), block.getRotation(), block.type());
 	}
-	for (auto iter : blocks) {
-		for (connection_end_id_t id = 0; id <= iter.second.getConnectionContainer().getMaxConnectionId(); id++) {
-			if (iter.second.isConnectionInput(id)) continue;
-			for (auto connectionIter : iter.second.getConnectionContainer().getConnections(id)) {
-				difference.addCreatedConnection(iter.second.getConnectionPosition(id).first, getBlock(connectionIter.getBlockId())->getConnectionPosition(connectionIter.getConnectionId()).first);
+	for (const Block& block : *this) {
+		for (connection_end_id_t id = 0; id <= block.getConnectionContainer().getMaxConnectionId(); id++) {
+			if (block.isConnectionInput(id)) continue;
+			for (auto connectionIter : block.getConnectionContainer().getConnections(id)) {
+				difference.addCreatedConnection(block.getConnectionPosition(id).first, getBlock(connectionIter.getBlockId())->getConnectionPosition(connectionIter.getConnectionId()).first);
 			}
 		}
 	}
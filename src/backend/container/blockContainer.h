@@ -1,14 +1,18 @@
 #ifndef blockContainer_h
 #define blockContainer_h
 
+#include <iterator>
+#include <memory>
+
 #include "backend/position/sparse2d.h"
+#include "backend/position/gridBuckets.h"
 #include "block/block.h"
 #include "difference.h"
 #include "cell.h"
 
 class BlockContainer {
 public:
-	inline BlockContainer() : lastId(0), grid(), blocks() { }
+	inline BlockContainer() : grid(), blockChunks(), slotGenerations(), freeBlockSlots(), blockIndex(), connectionIndex() { }
 
 	/* ----------- collision ----------- */
 	inline bool checkCollision(const Position& position) { return getCell(position); }
@@ -20,12 +24,13 @@ public:
 	inline const Cell* getCell(const Position& position) const { return grid.get(position);; }
 	// Gets the number of cells in the BlockContainer
 	inline unsigned int getCellCount() const { return grid.size(); }
-	// Gets the block that has a cell at that position. Returns nullptr the cell is empty
+	// Gets the block that has a cell at that position. Returns nullptr the cell is empty.
+	// Blocks never move in memory so the pointer stays valid until that block is removed
 	inline const Block* getBlock(const Position& position) const;
 	// Gets the block that has a id. Returns nullptr if no block has the id
 	inline const Block* getBlock(block_id_t blockId) const;
 	// Gets the number of blocks in the BlockContainer
-	inline unsigned int getBlockCount() const { return blocks.size(); }
+	inline unsigned int getBlockCount() const { return blockCount; }
 
 	// -- setters --
 	// Trys to insert a block. Returns if successful. Pass a Difference* to read the what changes were made.
@@ -40,6 +45,13 @@ public:
 	bool tryRemoveBlock(const Position& position, Difference* difference);
 	// Trys to move a block. Returns if successful. Pass a Difference* to read the what changes were made.
 	bool tryMoveBlock(const Position& positionOfBlock, const Position& position, Difference* difference);
+	// Fills small to large (inclusive) with blocks where they fit. Checks the whole area for collisions once and
+	// only checks block by block if something is in the way. Returns the number of blocks placed.
+	unsigned int tryInsertOverArea(const Position& small, const Position& large, Rotation rotation, BlockType blockType, Difference* difference);
+	// Removes every block with a cell from small to large (inclusive). Returns the number of blocks removed.
+	unsigned int tryRemoveOverArea(const Position& small, const Position& large, Difference* difference);
+	// Makes room for blockCount more blocks so big edits dont reallocate on the way
+	void reserveBlocks(unsigned int blockCount);
 
 	/* ----------- block data ----------- */
 	// // Gets the data from a block at position. Returns 0 if no block is found. 
@@ -75,14 +87,72 @@ public:
 	// Trys to remove a connection. Returns if successful. Pass a Difference* to read the what changes were made.
 	bool tryRemoveConnection(const Position& outputPosition, const Position& inputPosition, Difference* difference);
 
+	/* ----------- spatial queries ----------- */
+	// Gets the blocks with a cell from small to large (inclusive). Costs what is near the area, not the whole container
+	std::vector<const Block*> getBlocksInArea(const Position& small, const Position& large) const;
+	// Gets the connections as {output end, input end} whose bounding box overlaps small to large (inclusive)
+	std::vector<std::pair<ConnectionEnd, ConnectionEnd>> getConnectionsInArea(const Position& small, const Position& large) const;
+
 	/* ----------- iterators ----------- */
-	// not safe if the container gets modifided (dont worry about it for now)
-	typedef std::unordered_map<block_id_t, Block>::iterator iterator;
-	typedef std::unordered_map<block_id_t, Block>::const_iterator const_iterator;
-	iterator begin() { return blocks.begin(); }
-	iterator end() { return blocks.end(); }
-	const_iterator begin() const { return blocks.begin(); }
-	const_iterator end() const { return blocks.end(); }
+	// a linear scan over the block slots that skips the free ones. adding a block while iterating can
+	// put it in a slot that was already passed
+	template<class ContainerType, class BlockClass>
+	class SlotIterator {
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef Block value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef BlockClass* pointer;
+		typedef BlockClass& reference;
+
+		// the end iterator has no block
+		SlotIterator(ContainerType* container, bool atEnd) : container(container), block(nullptr), chunkEnd(nullptr), chunk(0) {
+			if (atEnd) return;
+			enterChunk();
+			skipFreeSlots();
+		}
+		reference operator*() const { return *block; }
+		pointer operator->() const { return block; }
+		SlotIterator& operator++() { ++block; skipFreeSlots(); return *this; }
+		SlotIterator operator++(int) { SlotIterator old = *this; ++*this; return old; }
+		bool operator==(const SlotIterator& other) const { return block == other.block; }
+		bool operator!=(const SlotIterator& other) const { return block != other.block; }
+
+	private:
+		// points block at the first slot of chunk, or at nothing past the last slot
+		void enterChunk() {
+			const size_t firstSlot = (size_t)chunk << BLOCK_CHUNK_BITS;
+			if (firstSlot >= container->slotGenerations.size()) {
+				block = nullptr;
+				return;
+			}
+			block = container->blockChunks[chunk].get();
+			chunkEnd = block + std::min<size_t>(BLOCK_CHUNK_MASK + 1, container->slotGenerations.size() - firstSlot);
+		}
+		void skipFreeSlots() {
+			while (block) {
+				if (block == chunkEnd) {
+					++chunk;
+					enterChunk();
+				} else if (block->type() == BlockType::NONE) {
+					++block;
+				} else {
+					return;
+				}
+			}
+		}
+
+		ContainerType* container;
+		pointer block;
+		pointer chunkEnd;
+		unsigned int chunk;
+	};
+	typedef SlotIterator<BlockContainer, Block> iterator;
+	typedef SlotIterator<const BlockContainer, const Block> const_iterator;
+	iterator begin() { return iterator(this, false); }
+	iterator end() { return iterator(this, true); }
+	const_iterator begin() const { return const_iterator(this, false); }
+	const_iterator end() const { return const_iterator(this, true); }
 
 	/* Difference Getter */
 	Difference getCreationDifference() const;
@@ -96,31 +166,55 @@ private:
 	void placeBlockCells(const Position& position, Rotation rotation, BlockType type, block_id_t blockId);
 	void placeBlockCells(const Block* block);
 	void removeBlockCells(const Block* block);
-	block_id_t getNewId() { return ++lastId; }
+	// keeps connectionIndex up to date, the blocks on both ends have to exist
+	void indexConnection(const ConnectionEnd& outputEnd, const ConnectionEnd& inputEnd, bool add);
+	// every connection of the block, call before it moves or is removed and again after it moved
+	void indexBlockConnections(const Block* block, bool add);
+	// puts a block with a new id in a free slot
+	Block& addBlock(BlockType blockType);
+	void eraseBlock(block_id_t blockId);
+	inline Block& blockAt(unsigned int slot) { return blockChunks[slot >> BLOCK_CHUNK_BITS][slot & BLOCK_CHUNK_MASK]; }
+	inline const Block& blockAt(unsigned int slot) const { return blockChunks[slot >> BLOCK_CHUNK_BITS][slot & BLOCK_CHUNK_MASK]; }
+
+	// ids are a slot in the low bits and the generation of the slot in the rest, so the id of a removed block
+	// never finds the block that reuses its slot. a slot that used up its generations is never reused
+	static constexpr unsigned int BLOCK_SLOT_BITS = 24;
+	static constexpr block_id_t BLOCK_SLOT_MASK = ((block_id_t)1 << BLOCK_SLOT_BITS) - 1;
+	static constexpr block_id_t BLOCK_GENERATION_COUNT = (block_id_t)1 << (sizeof(block_id_t) * 8 - BLOCK_SLOT_BITS);
+	// blocks live in chunks that never move, the block of a slot is always at the same address
+	static constexpr unsigned int BLOCK_CHUNK_BITS = 10;
+	static constexpr unsigned int BLOCK_CHUNK_MASK = (1 << BLOCK_CHUNK_BITS) - 1;
 
-	block_id_t lastId;
 	Sparse2d<Cell> grid;
-	std::unordered_map<block_id_t, Block> blocks;
+	std::vector<std::unique_ptr<Block[]>> blockChunks;
+	std::vector<block_id_t> slotGenerations; // never 0 for a slot in use so no id is 0, free slots hold a NONE block
+	std::vector<unsigned int> freeBlockSlots;
+	unsigned int blockCount = 0;
+	// for the renderer and other queries over an area
+	GridBuckets<block_id_t> blockIndex;
+	GridBuckets<std::pair<ConnectionEnd, ConnectionEnd>> connectionIndex;
 };
 
 inline Block* BlockContainer::getBlock(const Position& position) {
 	const Cell* cell = grid.get(position);
-	return cell == nullptr ? nullptr : &(blocks.find(cell->getBlockId())->second);
+	return cell == nullptr ? nullptr : &blockAt(cell->getBlockId() & BLOCK_SLOT_MASK);
 }
 
 inline const Block* BlockContainer::getBlock(const Position& position) const {
 	const Cell* cell = grid.get(position);
-	return cell == nullptr ? nullptr : &(blocks.find(cell->getBlockId())->second);
+	return cell == nullptr ? nullptr : &blockAt(cell->getBlockId() & BLOCK_SLOT_MASK);
 }
 
 inline Block* BlockContainer::getBlock(block_id_t blockId) {
-	auto iter = blocks.find(blockId);
-	return (iter == blocks.end()) ? nullptr : &iter->second;
+	const unsigned int slot = blockId & BLOCK_SLOT_MASK;
+	if (slot >= slotGenerations.size() || slotGenerations[slot] != blockId >> BLOCK_SLOT_BITS) return nullptr;
+	return &blockAt(slot);
 }
 
 inline const Block* BlockContainer::getBlock(block_id_t blockId) const {
-	auto iter = blocks.find(blockId);
-	return (iter == blocks.end()) ? nullptr : &iter->second;
+	const unsigned int slot = blockId & BLOCK_SLOT_MASK;
+	if (slot >= slotGenerations.size() || slotGenerations[slot] != blockId >> BLOCK_SLOT_BITS) return nullptr;
+	return &blockAt(slot);
 }
 
 template<class T, unsigned int index>
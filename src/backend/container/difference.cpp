@@ -0,0 +1,52 @@
+#include "difference.h"
+
+namespace {
+
+// reads the varint that ends right before byte and moves byte to its start
+inline uint32_t readVarintBackwards(const std::vector<uint8_t>& bytes, unsigned int& byte) {
+	unsigned int start = byte - 1;
+	// every byte but the last of a varint has the high bit set
+	while (start > 0 && (bytes[start - 1] & 0x80)) --start;
+	byte = start;
+	uint32_t value = 0;
+	for (unsigned int i = start; ; ++i) {
+		value |= (uint32_t)(bytes[i] & 0x7f) << ((i - start) * 7);
+		if (!(bytes[i] & 0x80)) break;
+	}
+	return (value >> 1) ^ (~(value & 1) + 1);
+}
+
+} // namespace
+
+Difference::const_iterator Difference::end() const {
+	const_iterator iterator;
+	iterator.difference = this;
+	iterator.index = kinds.size();
+	iterator.positionByte = positions.size();
+	iterator.dataIndex = data.size();
+	iterator.lastPosition = lastPosition;
+	return iterator;
+}
+
+void Difference::reserve(unsigned int modificationCount) {
+	kinds.reserve(modificationCount);
+	// a short delta for each coordinate
+	positions.reserve(modificationCount * 2);
+}
+
+size_t Difference::memoryUsage() const {
+	return sizeof(Difference) + kinds.capacity() * sizeof(uint16_t) + positions.capacity() + data.capacity() * sizeof(block_data_t);
+}
+
+Difference::const_iterator& Difference::const_iterator::operator--() {
+	--index;
+	const ModificationType type = getType(difference->kinds[index]);
+	// undo the deltas from the last coordinate back to the first
+	for (unsigned int i = positionCount(type); i > 0; --i) {
+		lastPosition.y = (cord_t)((uint32_t)lastPosition.y - readVarintBackwards(difference->positions, positionByte));
+		lastPosition.x = (cord_t)((uint32_t)lastPosition.x - readVarintBackwards(difference->positions, positionByte));
+	}
+	if (type == SET_DATA) dataIndex -= 2;
+	decode();
+	return *this;
+}
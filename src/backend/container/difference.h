@@ -1,8 +1,13 @@
 #ifndef difference_h
 #define difference_h
 
+#include "backend/position/position.h"
 #include "block/blockDefs.h"
 
+// Stores modifications by column instead of as a vector of variants. Each modification has a 16 bit kind
+// holding its type and for blocks the rotation and block type, positions are varint deltas from the position
+// before them and set data keeps its values in its own array. A placed block next to the last one takes 4 bytes
+// instead of a full Modification. Reading goes through iterators that decode one Modification at a time.
 class Difference {
 	friend class BlockContainer;
 public:
@@ -22,19 +27,176 @@ public:
 	// did not add move_modification_t because connection_modification_t has that data
 	typedef std::pair<ModificationType, std::variant<block_modification_t, connection_modification_t, data_modification_t>> Modification;
 
-	inline bool empty() const { return modifications.empty(); }
-	inline const std::vector<Modification>& getModifications() { return modifications; }
+	// bidirectional so undo can walk it backwards. dereferencing makes a Modification by value
+	class const_iterator {
+		friend class Difference;
+	public:
+		typedef std::bidirectional_iterator_tag iterator_category;
+		typedef Modification value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef Modification reference;
+		typedef void pointer;
+
+		const_iterator() = default;
+		inline Modification operator*() const;
+		inline const_iterator& operator++();
+		const_iterator operator++(int) { const_iterator old = *this; ++(*this); return old; }
+		const_iterator& operator--();
+		const_iterator operator--(int) { const_iterator old = *this; --(*this); return old; }
+		bool operator==(const const_iterator& other) const { return index == other.index; }
+		bool operator!=(const const_iterator& other) const { return index != other.index; }
+
+	private:
+		// reads the positions of the modification at index
+		inline void decode();
+
+		const Difference* difference = nullptr;
+		unsigned int index = 0; // into kinds
+		unsigned int positionByte = 0; // where the positions of this modification start
+		unsigned int nextPositionByte = 0; // where the ones of the next start
+		unsigned int dataIndex = 0;
+		Position lastPosition; // the positions of this modification are deltas from it
+		Position firstPosition, secondPosition; // of this modification
+	};
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+	// what getModifications returns, cheap to copy and only valid while the Difference is
+	class ModificationView {
+	public:
+		ModificationView(const Difference* difference) : difference(difference) { }
+		const_iterator begin() const { return difference->begin(); }
+		const_iterator end() const { return difference->end(); }
+		const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+		const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+		unsigned int size() const { return difference->size(); }
+		bool empty() const { return difference->empty(); }
+	private:
+		const Difference* difference;
+	};
+
+	inline bool empty() const { return kinds.empty(); }
+	inline unsigned int size() const { return kinds.size(); }
+	inline ModificationView getModifications() const { return ModificationView(this); }
+	inline const_iterator begin() const;
+	const_iterator end() const;
+	// reserves for modificationCount placed blocks
+	void reserve(unsigned int modificationCount);
+	// bytes held by the columns
+	size_t memoryUsage() const;
 
 private:
-	void addRemovedBlock(const Position& position, Rotation rotation, BlockType type) { modifications.push_back({ REMOVED_BLOCK, std::make_tuple(position, rotation, type) }); }
-	void addPlacedBlock(const Position& position, Rotation rotation, BlockType type) { modifications.push_back({ PLACE_BLOCK, std::make_tuple(position, rotation, type) }); }
-	void addMovedBlock(const Position& curPosition, const Position& newPosition) { modifications.push_back({ MOVE_BLOCK, std::make_pair(curPosition, newPosition) }); }
-	void addRemovedConnection(const Position& outputPosition, const Position& inputPosition) { modifications.push_back({ REMOVED_CONNECTION, std::make_pair(outputPosition, inputPosition) }); }
-	void addCreatedConnection(const Position& outputPosition, const Position& inputPosition) { modifications.push_back({ CREATED_CONNECTION, std::make_pair(outputPosition, inputPosition) }); }
-	void addSetData(const Position& position, block_data_t newData, block_data_t oldData) { modifications.push_back({ SET_DATA, std::make_tuple(position, newData, oldData) }); }
-
-	std::vector<Modification> modifications;
+	void addRemovedBlock(const Position& position, Rotation rotation, BlockType type) { addBlock(REMOVED_BLOCK, position, rotation, type); }
+	void addPlacedBlock(const Position& position, Rotation rotation, BlockType type) { addBlock(PLACE_BLOCK, position, rotation, type); }
+	void addMovedBlock(const Position& curPosition, const Position& newPosition) { addPositionPair(MOVE_BLOCK, curPosition, newPosition); }
+	void addRemovedConnection(const Position& outputPosition, const Position& inputPosition) { addPositionPair(REMOVED_CONNECTION, outputPosition, inputPosition); }
+	void addCreatedConnection(const Position& outputPosition, const Position& inputPosition) { addPositionPair(CREATED_CONNECTION, outputPosition, inputPosition); }
+	void addSetData(const Position& position, block_data_t newData, block_data_t oldData) {
+		kinds.push_back(SET_DATA);
+		addPosition(position);
+		data.push_back(newData);
+		data.push_back(oldData);
+	}
+
+	inline void addBlock(ModificationType type, const Position& position, Rotation rotation, BlockType blockType) {
+		kinds.push_back(type | ((uint16_t)rotation << TYPE_BITS) | ((uint16_t)blockType << (TYPE_BITS + ROTATION_BITS)));
+		addPosition(position);
+	}
+	inline void addPositionPair(ModificationType type, const Position& first, const Position& second) {
+		kinds.push_back(type);
+		addPosition(first);
+		addPosition(second);
+	}
+	inline void addPosition(const Position& position) {
+		// wraps around instead of overflowing, decoding wraps back
+		addVarint((uint32_t)position.x - (uint32_t)lastPosition.x);
+		addVarint((uint32_t)position.y - (uint32_t)lastPosition.y);
+		lastPosition = position;
+	}
+	// zigzag so small negative deltas stay small, then 7 bits a byte with the high bit set on all but the last
+	inline void addVarint(uint32_t delta) {
+		uint32_t value = (delta << 1) ^ (uint32_t)((int32_t)delta >> 31);
+		while (value >= 0x80) {
+			positions.push_back((uint8_t)(value | 0x80));
+			value >>= 7;
+		}
+		positions.push_back((uint8_t)value);
+	}
+	static inline unsigned int positionCount(ModificationType type) {
+		return (type == MOVE_BLOCK || type == REMOVED_CONNECTION || type == CREATED_CONNECTION) ? 2 : 1;
+	}
+	// reads the varint at byte and moves byte past it
+	static inline uint32_t readVarint(const std::vector<uint8_t>& bytes, unsigned int& byte) {
+		uint32_t value = bytes[byte++];
+		if (value & 0x80) {
+			value &= 0x7f;
+			unsigned int shift = 7;
+			while (bytes[byte] & 0x80) {
+				value |= (uint32_t)(bytes[byte++] & 0x7f) << shift;
+				shift += 7;
+			}
+			value |= (uint32_t)bytes[byte++] << shift;
+		}
+		return (value >> 1) ^ (~(value & 1) + 1);
+	}
+	static inline Position readPosition(const std::vector<uint8_t>& bytes, unsigned int& byte, const Position& lastPosition) {
+		const uint32_t dx = readVarint(bytes, byte);
+		const uint32_t dy = readVarint(bytes, byte);
+		return Position((cord_t)((uint32_t)lastPosition.x + dx), (cord_t)((uint32_t)lastPosition.y + dy));
+	}
+
+	static constexpr unsigned int TYPE_BITS = 3;
+	static constexpr unsigned int ROTATION_BITS = 2;
+	static constexpr uint16_t TYPE_MASK = (1 << TYPE_BITS) - 1;
+	static inline ModificationType getType(uint16_t kind) { return (ModificationType)(kind & TYPE_MASK); }
+	static_assert(SET_DATA <= TYPE_MASK && BlockType::TYPE_COUNT <= (1 << (16 - TYPE_BITS - ROTATION_BITS)));
+
+	std::vector<uint16_t> kinds; // of each modification in order
+	std::vector<uint8_t> positions;
+	std::vector<block_data_t> data; // new and old data of SET_DATA
+	Position lastPosition; // of the last added modification
 };
 typedef std::shared_ptr<Difference> DifferenceSharedPtr;
 
+inline Difference::const_iterator Difference::begin() const {
+	const_iterator iterator;
+	iterator.difference = this;
+	if (!empty()) iterator.decode();
+	return iterator;
+}
+
+inline void Difference::const_iterator::decode() {
+	nextPositionByte = positionByte;
+	firstPosition = readPosition(difference->positions, nextPositionByte, lastPosition);
+	if (positionCount(getType(difference->kinds[index])) == 2) {
+		secondPosition = readPosition(difference->positions, nextPositionByte, firstPosition);
+	}
+}
+
+inline Difference::Modification Difference::const_iterator::operator*() const {
+	const uint16_t kind = difference->kinds[index];
+	const ModificationType type = getType(kind);
+	switch (type) {
+	case REMOVED_BLOCK:
+	case PLACE_BLOCK:
+	{
+		const Rotation rotation = (Rotation)((kind >> TYPE_BITS) & ((1 << ROTATION_BITS) - 1));
+		const BlockType blockType = (BlockType)(kind >> (TYPE_BITS + ROTATION_BITS));
+		return { type, std::make_tuple(firstPosition, rotation, blockType) };
+	}
+	case SET_DATA:
+		return { type, std::make_tuple(firstPosition, difference->data[dataIndex], difference->data[dataIndex + 1]) };
+	default:
+		return { type, std::make_pair(firstPosition, secondPosition) };
+	}
+}
+
+inline Difference::const_iterator& Difference::const_iterator::operator++() {
+	const ModificationType type = getType(difference->kinds[index]);
+	if (type == SET_DATA) dataIndex += 2;
+	lastPosition = positionCount(type) == 2 ? secondPosition : firstPosition;
+	positionByte = nextPositionByte;
+	if (++index < difference->kinds.size()) decode();
+	return *this;
+}
+
 #endif /* difference_h */
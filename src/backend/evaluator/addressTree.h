@@ -4,6 +4,7 @@
 #include <stdexcept>
 
 #include "backend/address.h"
+#include "backend/position/positionMap.h"
 
 template <class T>
 class AddressTreeNode {
@@ -15,13 +16,16 @@ public:
 	void makeBranch(Position position, circuit_id_t containerId);
 	void makeBranch(const Address& address, circuit_id_t containerId);
 
-	void removeValue(Position position) { values.erase(position); }
+	void removeValue(Position position) { values.remove(position); }
 	void removeValue(const Address& address) {
-		const_cast<AddressTreeNode<T>&>(getParentBranch(address)).values.erase(address.getPosition(address.size() - 1));
+		getParentBranch(address).values.remove(address.getPosition(address.size() - 1));
 	}
 
-	inline T getValue(Position position) const { return values.at(position); }
+	inline T getValue(Position position) const;
+	inline void setValue(Position position, T value);
 	inline T getValue(const Address& address) const { return getParentBranch(address).getValue(address.getPosition(address.size() - 1)); }
+	// for bulk reads, see FlatPositionMap::get
+	inline T getValue(const Address& address, unsigned int& hint) const;
 
 	// Added const overload for getParentBranch
 	AddressTreeNode<T>& getParentBranch(const Address& address);
@@ -30,7 +34,7 @@ public:
 	inline const AddressTreeNode<T>& getBranch(Position position) const;
 	const AddressTreeNode<T>& getBranch(const Address& address) const;
 
-	inline bool hasValue(Position position) const { return values.find(position) != values.end(); }
+	inline bool hasValue(Position position) const { return values.contains(position); }
 	inline bool hasBranch(Position position) const { return branches.find(position) != branches.end(); }
 
 	void moveData(Position curPosition, Position newPosition);
@@ -39,7 +43,7 @@ public:
 	circuit_id_t getContainerId() const { return containerId; }
 
 private:
-	std::unordered_map<Position, T> values;
+	FlatPositionMap<T> values; // looked up for every visible block each frame
 	std::unordered_map<Position, AddressTreeNode<T>> branches;
 	circuit_id_t containerId;
 };
@@ -49,7 +53,7 @@ void AddressTreeNode<T>::addValue(Position position, T value) {
 	if (hasValue(position) || hasBranch(position)) {
 		throw std::invalid_argument("AddressTree::addValue: position already exists");
 	}
-	values[position] = value;
+	values.insert(position, value);
 }
 
 template<class T>
@@ -62,6 +66,33 @@ void AddressTreeNode<T>::addValue(const Address& address, T value) {
 	parentBranch.addValue(finalPosition, value);
 }
 
+template<class T>
+T AddressTreeNode<T>::getValue(Position position) const {
+	const T* value = values.get(position);
+	if (!value) {
+		throw std::out_of_range("AddressTree::getValue: address not found");
+	}
+	return *value;
+}
+
+template<class T>
+T AddressTreeNode<T>::getValue(const Address& address, unsigned int& hint) const {
+	const T* value = getParentBranch(address).values.get(address.getPosition(address.size() - 1), hint);
+	if (!value) {
+		throw std::out_of_range("AddressTree::getValue: address not found");
+	}
+	return *value;
+}
+
+template<class T>
+void AddressTreeNode<T>::setValue(Position position, T value) {
+	T* oldValue = values.get(position);
+	if (!oldValue) {
+		throw std::out_of_range("AddressTree::setValue: address not found");
+	}
+	*oldValue = value;
+}
+
 template<class T>
 void AddressTreeNode<T>::makeBranch(Position position, circuit_id_t containerId) {
 	if (hasValue(position) || hasBranch(position)) {
@@ -98,10 +129,10 @@ const AddressTreeNode<T>& AddressTreeNode<T>::getBranch(const Address& address)
 
 template<class T>
 void AddressTreeNode<T>::moveData(Position curPosition, Position newPosition) {
-	if (hasValue(curPosition)) {
-		auto pair = values.extract(curPosition);
-		pair.key() = newPosition;
-		values.insert(std::move(pair));
+	if (const T* value = values.get(curPosition)) {
+		const T movedValue = *value;
+		values.remove(curPosition);
+		values.insert(newPosition, movedValue);
 	} else {
 		auto pair = branches.extract(curPosition);
 		pair.key() = newPosition;
@@ -111,12 +142,12 @@ void AddressTreeNode<T>::moveData(Position curPosition, Position newPosition) {
 
 template<class T>
 void AddressTreeNode<T>::remap(const std::unordered_map<T, T>& mapping) {
-	for (auto& [position, value] : values) {
+	values.forEach([&mapping](Position position, T& value) {
 		auto it = mapping.find(value);
 		if (it != mapping.end()) {
 			value = it->second;
 		}
-	}
+	});
 	for (auto& [position, branch] : branches) {
 		branch.remap(mapping);
 	}
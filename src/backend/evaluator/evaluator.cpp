@@ -3,17 +3,25 @@
 Evaluator::Evaluator(evaluator_id_t evaluatorId, SharedCircuit circuit)
 	: evaluatorId(evaluatorId), paused(true),
 	targetTickrate(0),
-	logicSimulator(),
 	addressTree(circuit->getCircuitId()),
+	logicSimulator(),
 	usingTickrate(false) {
 	setTickrate(40 * 60); // 1000000000 clocks / min
 	const auto blockContainer = circuit->getBlockContainer();
 	const Difference difference = blockContainer->getCreationDifference();
 
-	makeEdit(std::make_shared<Difference>(difference), circuit->getCircuitId());
+	queueCircuitEdit(std::make_shared<Difference>(difference));
+	logicSimulator.setIdleTask([this]() {
+		if (autoReorder && placedSinceReorder >= REORDER_MIN_PLACED && placedSinceReorder * 4 >= logicSimulator.getGateCount()) {
+			applyReorder(); // drops the holes too
+		} else if (logicSimulator.getDecomissionedCount() > 0) {
+			std::lock_guard<std::mutex> lock(addressMutex);
+			if (fillGateHoles()) logicSimulator.publishSnapshot();
+		}
+	});
 
-	// connect makeEdit to circuit
-	circuit->connectListener(this, std::bind(&Evaluator::makeEdit, this, std::placeholders::_1, std::placeholders::_2));
+	// connect the edits to circuit
+	circuit->connectListener(this, std::bind(&Evaluator::queueCircuitEdit, this, std::placeholders::_1));
 }
 
 void Evaluator::setPause(bool pause) {
@@ -27,7 +35,9 @@ void Evaluator::setPause(bool pause) {
 }
 
 void Evaluator::reset() {
-	logicSimulator.initialize(); // wipes all the states
+	logicSimulator.queueEdit([this]() {
+		logicSimulator.initialize(); // wipes all the states
+	});
 }
 
 void Evaluator::setTickrate(unsigned long long tickrate) {
@@ -53,30 +63,56 @@ long long int Evaluator::getRealTickrate() const {
 	return paused ? 0 : logicSimulator.getRealTickrate();
 }
 
+void Evaluator::setEvaluationMode(EvaluationMode mode) {
+	runOnSimulationThread([this, mode]() {
+		logicSimulator.setEvaluationMode(mode);
+	});
+}
+
+void Evaluator::setWorkerCount(unsigned int count) {
+	runOnSimulationThread([this, count]() {
+		logicSimulator.setWorkerCount(count);
+	});
+}
+
 
-void Evaluator::runNTicks(unsigned long long n) {
-	// TODO: make this happen in the thread via leaky bucket
-	logicSimulator.simulateNTicks(n);
+std::future<void> Evaluator::runNTicks(unsigned long long n) {
+	return logicSimulator.queueTicks(n);
 }
 
-void Evaluator::makeEdit(DifferenceSharedPtr difference, circuit_id_t containerId) {
-	logicSimulator.signalToPause();
-	// wait for the thread to pause
-	while (!logicSimulator.threadIsWaiting()) {
-		std::this_thread::yield();
-	}
+std::future<void> Evaluator::makeEdit(DifferenceSharedPtr difference, circuit_id_t containerId) {
+	// applied by the simulation thread at the next tick boundary
+	return logicSimulator.queueEdit([this, difference]() {
+		applyDifference(difference);
+	});
+}
+
+void Evaluator::queueCircuitEdit(DifferenceSharedPtr difference) {
+	logicSimulator.queueEdit([this, difference]() {
+		try {
+			applyDifference(difference);
+		} catch (const std::exception& error) {
+			// the evaluator no longer matches the circuit
+			std::cerr << "Evaluator " << evaluatorId << " failed to apply a circuit edit: " << error.what() << std::endl;
+			throw;
+		}
+	});
+}
+
+void Evaluator::applyDifference(const DifferenceSharedPtr& difference) {
+	std::lock_guard<std::mutex> lock(addressMutex);
 	const auto modifications = difference->getModifications();
-	bool deletedBlocks = false;
+	bool placedBlocks = false;
 	for (const auto& modification : modifications) {
 		const auto& [modificationType, modificationData] = modification;
 		switch (modificationType) {
 		case Difference::REMOVED_BLOCK:
 		{
-			deletedBlocks = true;
 			const auto& [position, rotation, blockType] = std::get<Difference::block_modification_t>(modificationData);
 			const auto address = Address(position);
-			const block_id_t blockId = addressTree.getValue(address);
-			logicSimulator.decomissionGate(blockId);
+			const GateHandle handle = addressTree.getValue(address);
+			logicSimulator.decomissionGate(gateHandleMap.get(handle));
+			gateHandleMap.remove(handle);
 			addressTree.removeValue(address);
 			break;
 		}
@@ -86,7 +122,12 @@ void Evaluator::makeEdit(DifferenceSharedPtr difference, circuit_id_t containerI
 			const auto address = Address(position);
 			const GateType gateType = circuitToEvaluatorGatetype(blockType);
 			const block_id_t blockId = logicSimulator.addGate(gateType, true);
-			addressTree.addValue(address, blockId);
+			const GateHandle handle = gateHandleMap.insert(blockId);
+			addressTree.addValue(address, handle);
+			if (blockId >= gateHandles.size()) gateHandles.resize(blockId + 1);
+			gateHandles[blockId] = handle;
+			++placedSinceReorder;
+			placedBlocks = true;
 			break;
 		}
 		case Difference::REMOVED_CONNECTION:
@@ -94,8 +135,8 @@ void Evaluator::makeEdit(DifferenceSharedPtr difference, circuit_id_t containerI
 			const auto& [outputPosition, inputPosition] = std::get<Difference::connection_modification_t>(modificationData);
 			const auto outputAddress = Address(outputPosition);
 			const auto inputAddress = Address(inputPosition);
-			const block_id_t outputBlockId = addressTree.getValue(outputAddress);
-			const block_id_t inputBlockId = addressTree.getValue(inputAddress);
+			const block_id_t outputBlockId = getGate(outputAddress);
+			const block_id_t inputBlockId = getGate(inputAddress);
 			logicSimulator.disconnectGates(outputBlockId, inputBlockId);
 			break;
 		}
@@ -104,29 +145,73 @@ void Evaluator::makeEdit(DifferenceSharedPtr difference, circuit_id_t containerI
 			const auto& [outputPosition, inputPosition] = std::get<Difference::connection_modification_t>(modificationData);
 			const auto outputAddress = Address(outputPosition);
 			const auto inputAddress = Address(inputPosition);
-			const block_id_t outputBlockId = addressTree.getValue(outputAddress);
-			const block_id_t inputBlockId = addressTree.getValue(inputAddress);
+			const block_id_t outputBlockId = getGate(outputAddress);
+			const block_id_t inputBlockId = getGate(inputAddress);
 			logicSimulator.connectGates(outputBlockId, inputBlockId);
 			break;
 		}
 		case Difference::MOVE_BLOCK:
 		{
 			const auto& [curPosition, newPosition] = std::get<Difference::move_modification_t>(modificationData);
-			addressTree.moveData(curPosition, newPosition);
+			addressTree.moveData(curPosition, newPosition); // the handle moves with the block
 			break;
 		}
 		case Difference::SET_DATA: break;
 		}
 	}
-	if (deletedBlocks) {
-		const auto gateMap = logicSimulator.compressGates();
-		addressTree.remap(gateMap);
+	// new blocks reuse the holes, only compact here if a running simulation piles up more than it refills
+	bool movedGates = false;
+	if (logicSimulator.getDecomissionedCount() * HOLE_COMPACT_RATIO > logicSimulator.getGateCount()) {
+		movedGates = fillGateHoles();
 	}
-	if (!paused) {
-		logicSimulator.signalToProceed();
+	// readers look up ids and states under the same lock so publish before they can see the new ids
+	if (placedBlocks || movedGates) {
+		logicSimulator.publishSnapshot();
 	}
 }
 
+bool Evaluator::fillGateHoles() {
+	// move gates from the end into the holes left by removed ones, the address tree keeps its handles
+	const auto moves = logicSimulator.fillGateHoles();
+	moveGateHandles(moves);
+	gateHandles.resize(logicSimulator.getGateCount());
+	return !moves.empty();
+}
+
+void Evaluator::moveGateHandles(const std::vector<std::pair<block_id_t, block_id_t>>& moves) {
+	// a gate can be moved into the old id of another moved gate so read every handle before writing any
+	std::vector<GateHandle> movedHandles;
+	movedHandles.reserve(moves.size());
+	for (const auto& move : moves) {
+		movedHandles.push_back(gateHandles[move.first]);
+	}
+	for (unsigned int i = 0; i < moves.size(); ++i) {
+		gateHandleMap.setGate(movedHandles[i], moves[i].second);
+		gateHandles[moves[i].second] = movedHandles[i];
+	}
+}
+
+void Evaluator::reorderGates() {
+	runOnSimulationThread([this]() {
+		applyReorder();
+	});
+}
+
+void Evaluator::setAutoReorder(bool autoReorder) {
+	runOnSimulationThread([this, autoReorder]() {
+		this->autoReorder = autoReorder;
+	});
+}
+
+void Evaluator::applyReorder() {
+	std::lock_guard<std::mutex> lock(addressMutex);
+	placedSinceReorder = 0;
+	const auto moves = logicSimulator.reorderGates(logicSimulator.getLocalityOrder());
+	moveGateHandles(moves);
+	gateHandles.resize(logicSimulator.getGateCount());
+	if (!moves.empty()) logicSimulator.publishSnapshot();
+}
+
 GateType circuitToEvaluatorGatetype(BlockType blockType) {
 	switch (blockType) {
 	case BlockType::AND: return GateType::AND;
@@ -145,44 +230,104 @@ GateType circuitToEvaluatorGatetype(BlockType blockType) {
 }
 
 logic_state_t Evaluator::getState(const Address& address) {
-	const block_id_t blockId = addressTree.getValue(address);
-
-	logicSimulator.signalToPause();
-	while (!logicSimulator.threadIsWaiting()) {
-		std::this_thread::yield();
-	}
-	const logic_state_t state = logicSimulator.getState(blockId);
-	if (!paused) {
-		logicSimulator.signalToProceed();
-	}
-	return state;
+	logicSimulator.flushEdits();
+	std::lock_guard<std::mutex> lock(addressMutex);
+	const block_id_t blockId = getGate(address);
+	return logicSimulator.readSnapshot([blockId](const StateVector& states) { return states[blockId]; });
 }
 
 std::vector<logic_state_t> Evaluator::getBulkStates(const std::vector<Address>& addresses) {
-	std::vector<logic_state_t> states;
-	states.reserve(addresses.size());
-	logicSimulator.signalToPause();
-	while (!logicSimulator.threadIsWaiting()) {
-		std::this_thread::yield();
-	}
+	logicSimulator.flushEdits();
+	std::lock_guard<std::mutex> lock(addressMutex);
+	std::vector<block_id_t> blockIds;
+	blockIds.reserve(addresses.size());
+	// the renderer asks in the order the blocks were placed, which is the order the tree stores them in
+	unsigned int hint = 0;
 	for (const auto& address : addresses) {
-		const block_id_t blockId = addressTree.getValue(address);
-		states.push_back(logicSimulator.getState(blockId));
+		blockIds.push_back(gateHandleMap.get(addressTree.getValue(address, hint)));
 	}
-	if (!paused) {
-		logicSimulator.signalToProceed();
+	// reads the last published tick so rendering never stalls the simulation
+	std::vector<logic_state_t> states;
+	states.reserve(addresses.size());
+	logicSimulator.readSnapshot([&](const StateVector& snapshot) {
+		for (block_id_t blockId : blockIds) {
+			states.push_back(snapshot[blockId]);
+		}
+	});
+	return states;
+}
+
+GateHandle Evaluator::getGateHandle(const Address& address) {
+	logicSimulator.flushEdits();
+	std::lock_guard<std::mutex> lock(addressMutex);
+	return addressTree.getValue(address);
+}
+
+logic_state_t Evaluator::getState(GateHandle handle) {
+	logicSimulator.flushEdits();
+	std::lock_guard<std::mutex> lock(addressMutex);
+	const block_id_t blockId = gateHandleMap.get(handle);
+	return logicSimulator.readSnapshot([blockId](const StateVector& states) { return states[blockId]; });
+}
+
+std::vector<logic_state_t> Evaluator::getBulkStates(const std::vector<GateHandle>& handles) {
+	logicSimulator.flushEdits();
+	std::lock_guard<std::mutex> lock(addressMutex);
+	std::vector<block_id_t> blockIds;
+	blockIds.reserve(handles.size());
+	for (GateHandle handle : handles) {
+		blockIds.push_back(gateHandleMap.get(handle));
 	}
+	std::vector<logic_state_t> states;
+	states.reserve(handles.size());
+	logicSimulator.readSnapshot([&](const StateVector& snapshot) {
+		for (block_id_t blockId : blockIds) {
+			states.push_back(snapshot[blockId]);
+		}
+	});
 	return states;
 }
 
 void Evaluator::setState(const Address& address, logic_state_t state) {
-	const block_id_t blockId = addressTree.getValue(address);
-	logicSimulator.signalToPause();
-	while (!logicSimulator.threadIsWaiting()) {
-		std::this_thread::yield();
-	}
-	logicSimulator.setState(blockId, state);
-	if (!paused) {
-		logicSimulator.signalToProceed();
-	}
+	// look the address up here so a bad one throws to the caller, the handle follows the gate until the edit runs
+	const GateHandle handle = getGateHandle(address);
+	logicSimulator.queueEdit([this, handle, state]() {
+		std::lock_guard<std::mutex> lock(addressMutex);
+		if (gateHandleMap.contains(handle)) logicSimulator.setState(gateHandleMap.get(handle), state);
+	});
+}
+
+void Evaluator::setLaneStates(const std::vector<Address>& addresses, const std::vector<lane_word_t>& states) {
+	if (addresses.size() != states.size())
+		throw std::invalid_argument("setLaneStates: addresses and states must be the same size");
+	runOnSimulationThread([&]() {
+		std::lock_guard<std::mutex> lock(addressMutex);
+		for (unsigned int i = 0; i < addresses.size(); ++i) {
+			logicSimulator.setLaneStates(getGate(addresses[i]), states[i]);
+		}
+	});
+}
+
+std::vector<lane_word_t> Evaluator::getLaneStates(const std::vector<Address>& addresses) {
+	std::vector<lane_word_t> states;
+	states.reserve(addresses.size());
+	runOnSimulationThread([&]() {
+		std::lock_guard<std::mutex> lock(addressMutex);
+		for (const auto& address : addresses) {
+			states.push_back(logicSimulator.getLaneStates(getGate(address)));
+		}
+	});
+	return states;
+}
+
+void Evaluator::runLaneTicks(unsigned int n) {
+	runOnSimulationThread([this, n]() {
+		logicSimulator.simulateLaneTicks(n);
+	});
+}
+
+void Evaluator::resetLanes() {
+	runOnSimulationThread([this]() {
+		logicSimulator.resetLanes();
+	});
 }
@@ -5,6 +5,7 @@
 #include "backend/container/difference.h"
 #include "logicSimulator.h"
 #include "addressTree.h"
+#include "gateHandle.h"
 #include "backend/address.h"
 #include "logicState.h"
 
@@ -22,22 +23,80 @@ public:
 	void setTickrate(unsigned long long tickrate);
 	void setUseTickrate(bool useTickrate);
 	long long int getRealTickrate() const;
-	void runNTicks(unsigned long long n);
-	void makeEdit(DifferenceSharedPtr difference, circuit_id_t circuitId);
+	SimulatorMetrics getMetrics() const { return logicSimulator.getMetrics(); }
+	void setEvaluationMode(EvaluationMode mode);
+	EvaluationMode getEvaluationMode() const { return logicSimulator.getEvaluationMode(); }
+	void setWorkerCount(unsigned int count);
+	unsigned int getWorkerCount() const { return logicSimulator.getWorkerCount(); }
+	// runs n ticks on the simulation thread without the tickrate limit, ready once they are done
+	std::future<void> runNTicks(unsigned long long n);
+	// applied by the simulation thread, the future rethrows anything applying it threw
+	std::future<void> makeEdit(DifferenceSharedPtr difference, circuit_id_t circuitId);
+	// edits are queued and applied by the simulation thread, reads wait for queued edits first
 	logic_state_t getState(const Address& address);
+	// throws std::out_of_range for an unknown address, does nothing if the block is removed before it is applied
 	void setState(const Address& address, logic_state_t state);
 	std::vector<logic_state_t> getBulkStates(const std::vector<Address>& addresses);
 	std::vector<logic_state_t> getBulkStates(const std::vector<Address>& addresses, const Address& addressOrigin);
 	void setBulkStates(const std::vector<Address>& addresses, const std::vector<logic_state_t>& states);
 	void setBulkStates(const std::vector<Address>& addresses, const std::vector<logic_state_t>& states, const Address& addressOrigin);
 
+	// handles can be kept across edits and skip the address lookup, they stay valid until the block is removed.
+	// reads with a handle to a removed block throw std::out_of_range
+	GateHandle getGateHandle(const Address& address);
+	logic_state_t getState(GateHandle handle);
+	std::vector<logic_state_t> getBulkStates(const std::vector<GateHandle>& handles);
+
+	// renumbers the gates so connected ones are close in memory, also runs on its own once
+	// enough blocks were placed and the simulation is paused or steady
+	void reorderGates();
+	void setAutoReorder(bool autoReorder);
+
+	// bit sliced batch runs of LANE_COUNT stimuli at once, bit i of each word belongs to lane i.
+	// lanes run separately from the live simulation and block until done
+	void setLaneStates(const std::vector<Address>& addresses, const std::vector<lane_word_t>& states);
+	std::vector<lane_word_t> getLaneStates(const std::vector<Address>& addresses);
+	void runLaneTicks(unsigned int n);
+	void resetLanes();
+
 private:
+	void applyDifference(const DifferenceSharedPtr& difference);
+	// the circuit doesnt wait for its edits, so a difference that fails to apply is reported here instead
+	void queueCircuitEdit(DifferenceSharedPtr difference);
+	// compacts the simulator and moves the handles along, the caller holds addressMutex. true if any gate moved
+	bool fillGateHoles();
+	// holes are compacted when the simulation parks, a running one compacts once over 1 / HOLE_COMPACT_RATIO of the gates are holes
+	static constexpr unsigned int HOLE_COMPACT_RATIO = 8;
+	// points the handles of gates the simulator moved at their new ids
+	void moveGateHandles(const std::vector<std::pair<block_id_t, block_id_t>>& moves);
+	void applyReorder();
+	// small circuits fit in cache anyway and a reorder touches every gate, so wait for a lot of new blocks
+	static constexpr unsigned int REORDER_MIN_PLACED = 4096;
+	inline block_id_t getGate(const Address& address) const { return gateHandleMap.get(addressTree.getValue(address)); }
+	// runs func on the simulation thread, waits for it and rethrows anything it threw.
+	// already on it (idle task or a queued edit) func runs right away since waiting would deadlock
+	template<class Func>
+	void runOnSimulationThread(Func&& func) {
+		if (logicSimulator.onSimulationThread()) {
+			func();
+			return;
+		}
+		logicSimulator.queueEdit([&func]() { func(); }).get();
+	}
+
 	evaluator_id_t evaluatorId;
 	bool paused;
 	bool usingTickrate;
 	unsigned long long targetTickrate;
+	// declared before the simulator so they outlive its thread
+	std::mutex addressMutex;
+	AddressTreeNode<GateHandle> addressTree;
+	GateHandleMap gateHandleMap;
+	std::vector<GateHandle> gateHandles; // handle of each gate so moved gates can be found
+	// only used by the simulation thread
+	unsigned int placedSinceReorder = 0;
+	bool autoReorder = true;
 	LogicSimulator logicSimulator;
-	AddressTreeNode<block_id_t> addressTree;
 };
 
 GateType circuitToEvaluatorGatetype(BlockType blockType);
@@ -11,6 +11,9 @@ public:
 	inline long long int getRealTickrate() const {
 		return evaluator ? evaluator->getRealTickrate() : 0;
 	}
+	inline SimulatorMetrics getMetrics() const {
+		return evaluator ? evaluator->getMetrics() : SimulatorMetrics();
+	}
 
 	inline logic_state_t getState(const Address& address) {
 		return evaluator ? evaluator->getState(address) : false;
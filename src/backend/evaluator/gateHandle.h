@@ -0,0 +1,68 @@
+#ifndef gateHandle_h
+#define gateHandle_h
+
+#include <stdexcept>
+
+#include "backend/container/block/blockDefs.h"
+
+// Names a gate independently of where the simulator keeps it. The simulator moves gates around when
+// it fills holes or reorders them, a handle stays valid until its gate is removed. The generation
+// makes handles to removed gates invalid even after their slot is reused.
+struct GateHandle {
+	uint32_t slot = ~(uint32_t)0;
+	uint32_t generation = 0;
+
+	bool operator==(const GateHandle& other) const { return slot == other.slot && generation == other.generation; }
+	bool operator!=(const GateHandle& other) const { return !(*this == other); }
+};
+
+// Slot map from GateHandle to the current block_id_t of the gate. Lookups are one array read and a
+// generation check, when gates move only their slots need to change.
+class GateHandleMap {
+public:
+	GateHandle insert(block_id_t gate);
+	// throws std::out_of_range if the handle is invalid
+	void remove(GateHandle handle);
+	// throws std::out_of_range if the handle is invalid
+	inline block_id_t get(GateHandle handle) const {
+		if (!contains(handle)) throw std::out_of_range("GateHandleMap::get: invalid handle");
+		return handleSlots[handle.slot].gate;
+	}
+	inline bool contains(GateHandle handle) const {
+		return handle.slot < handleSlots.size() && handleSlots[handle.slot].generation == handle.generation && handleSlots[handle.slot].gate != INVALID_GATE;
+	}
+	// points a valid handle at the new id of its gate
+	inline void setGate(GateHandle handle, block_id_t gate) { handleSlots[handle.slot].gate = gate; }
+	inline unsigned int size() const { return handleSlots.size() - freeSlots.size(); }
+	void clear() { handleSlots.clear(); freeSlots.clear(); }
+
+private:
+	static constexpr block_id_t INVALID_GATE = ~(block_id_t)0;
+	struct Slot {
+		block_id_t gate;
+		uint32_t generation;
+	};
+	std::vector<Slot> handleSlots; // not named slots, Qt defines that as a macro
+	std::vector<uint32_t> freeSlots;
+};
+
+inline GateHandle GateHandleMap::insert(block_id_t gate) {
+	if (freeSlots.empty()) {
+		handleSlots.push_back({ gate, 0 });
+		return { (uint32_t)handleSlots.size() - 1, 0 };
+	}
+	const uint32_t slot = freeSlots.back();
+	freeSlots.pop_back();
+	handleSlots[slot].gate = gate;
+	return { slot, handleSlots[slot].generation };
+}
+
+inline void GateHandleMap::remove(GateHandle handle) {
+	if (!contains(handle)) throw std::out_of_range("GateHandleMap::remove: invalid handle");
+	// old handles to the slot stop matching once the generation changes
+	handleSlots[handle.slot].gate = INVALID_GATE;
+	++handleSlots[handle.slot].generation;
+	freeSlots.push_back(handle.slot);
+}
+
+#endif /* gateHandle_h */
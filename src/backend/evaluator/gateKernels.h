@@ -0,0 +1,196 @@
+#ifndef gateKernels_h
+#define gateKernels_h
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define GATE_KERNELS_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define GATE_KERNELS_SSE2
+#endif
+
+#include <optional>
+
+#include "stateVector.h"
+#include "gateType.h"
+
+// The gate types of 64 consecutive gates decoded into bit planes so a whole word of
+// gates can be evaluated without looking at each gate's type.
+struct GateTypeMasks {
+	state_word_t andMask = 0; // and + nand
+	state_word_t orMask = 0; // or + nor
+	state_word_t xorMask = 0; // xor + xnor
+	state_word_t invertMask = 0; // nand + nor + xnor
+	state_word_t constantOnMask = 0;
+	state_word_t holdMask = 0; // keeps its current state
+
+	inline void setType(unsigned int bit, GateType type) {
+		const state_word_t mask = (state_word_t)1 << bit;
+		andMask &= ~mask; orMask &= ~mask; xorMask &= ~mask;
+		invertMask &= ~mask; constantOnMask &= ~mask; holdMask &= ~mask;
+		switch (type) {
+		case GateType::NAND: invertMask |= mask; [[fallthrough]];
+		case GateType::AND: andMask |= mask; break;
+		case GateType::NOR: invertMask |= mask; [[fallthrough]];
+		case GateType::OR: orMask |= mask; break;
+		case GateType::XNOR: invertMask |= mask; [[fallthrough]];
+		case GateType::XOR: xorMask |= mask; break;
+		case GateType::CONSTANT_ON: constantOnMask |= mask; break;
+		case GateType::NONE:
+		case GateType::DEFAULT_RETURN_CURRENTSTATE: holdMask |= mask; break;
+		case GateType::TICK_INPUT: break;
+		}
+	}
+};
+
+// Masks with every bit set to the same type, used when the bits of a word are copies of one gate.
+inline GateTypeMasks broadcastGateType(GateType type) {
+	GateTypeMasks masks;
+	masks.setType(0, type);
+	auto broadcast = [](state_word_t mask) { return mask ? ~(state_word_t)0 : 0; };
+	return {
+		broadcast(masks.andMask), broadcast(masks.orMask), broadcast(masks.xorMask),
+		broadcast(masks.invertMask), broadcast(masks.constantOnMask), broadcast(masks.holdMask)
+	};
+}
+
+// Input count predicates for a word of gates. Bit i describes gate i of the word.
+struct GateInputWords {
+	state_word_t allPowered = 0;
+	state_word_t anyPowered = 0;
+	state_word_t oddPowered = 0;
+	state_word_t hasInputs = 0;
+};
+
+inline state_word_t combineGateWord(const GateTypeMasks& masks, const GateInputWords& inputs, state_word_t current) {
+	const state_word_t base = (masks.andMask & inputs.allPowered) | (masks.orMask & inputs.anyPowered) | (masks.xorMask & inputs.oddPowered);
+	return ((base ^ masks.invertMask) & inputs.hasInputs) | masks.constantOnMask | (masks.holdMask & current);
+}
+
+// Computes the predicates for the first count gates of a word one gate at a time.
+inline GateInputWords computeInputWordsScalar(const unsigned int* powered, const unsigned int* total, unsigned int count) {
+	GateInputWords inputs;
+	for (unsigned int i = 0; i < count; ++i) {
+		const state_word_t bit = (state_word_t)1 << i;
+		if (powered[i] == total[i]) inputs.allPowered |= bit;
+		if (powered[i]) inputs.anyPowered |= bit;
+		if (powered[i] & 1) inputs.oddPowered |= bit;
+		if (total[i]) inputs.hasInputs |= bit;
+	}
+	return inputs;
+}
+
+// Computes the chosen predicates for a full word of 64 gates, the others are left at zero.
+template<bool ALL, bool ANY, bool ODD, bool HAS>
+inline GateInputWords computeSelectedInputWords(const unsigned int* powered, const unsigned int* total) {
+#if defined(GATE_KERNELS_AVX2)
+	static_assert(sizeof(unsigned int) == 4);
+	GateInputWords inputs;
+	const __m256i zero = _mm256_setzero_si256();
+	for (unsigned int i = 0; i < STATE_WORD_BITS; i += 8) {
+		const __m256i p = _mm256_loadu_si256((const __m256i*)(powered + i));
+		if constexpr (ALL || HAS) {
+			const __m256i t = _mm256_loadu_si256((const __m256i*)(total + i));
+			if constexpr (ALL) inputs.allPowered |= (state_word_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(p, t))) << i;
+			if constexpr (HAS) inputs.hasInputs |= (state_word_t)(~_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(t, zero))) & 0xFF) << i;
+		}
+		if constexpr (ANY) inputs.anyPowered |= (state_word_t)(~_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(p, zero))) & 0xFF) << i;
+		if constexpr (ODD) inputs.oddPowered |= (state_word_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_slli_epi32(p, 31))) << i;
+	}
+	return inputs;
+#elif defined(GATE_KERNELS_SSE2)
+	static_assert(sizeof(unsigned int) == 4);
+	GateInputWords inputs;
+	const __m128i zero = _mm_setzero_si128();
+	for (unsigned int i = 0; i < STATE_WORD_BITS; i += 4) {
+		const __m128i p = _mm_loadu_si128((const __m128i*)(powered + i));
+		if constexpr (ALL || HAS) {
+			const __m128i t = _mm_loadu_si128((const __m128i*)(total + i));
+			if constexpr (ALL) inputs.allPowered |= (state_word_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(p, t))) << i;
+			if constexpr (HAS) inputs.hasInputs |= (state_word_t)(~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(t, zero))) & 0xF) << i;
+		}
+		if constexpr (ANY) inputs.anyPowered |= (state_word_t)(~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(p, zero))) & 0xF) << i;
+		if constexpr (ODD) inputs.oddPowered |= (state_word_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_slli_epi32(p, 31))) << i;
+	}
+	return inputs;
+#else
+	GateInputWords inputs = computeInputWordsScalar(powered, total, STATE_WORD_BITS);
+	if constexpr (!ALL) inputs.allPowered = 0;
+	if constexpr (!ANY) inputs.anyPowered = 0;
+	if constexpr (!ODD) inputs.oddPowered = 0;
+	if constexpr (!HAS) inputs.hasInputs = 0;
+	return inputs;
+#endif
+}
+
+// Computes the predicates for a full word of 64 gates.
+inline GateInputWords computeInputWords(const unsigned int* powered, const unsigned int* total) {
+	return computeSelectedInputWords<true, true, true, true>(powered, total);
+}
+
+// The type of every gate in a word if they are all the same. NONE and DEFAULT_RETURN_CURRENTSTATE
+// both keep their state so they come back as DEFAULT_RETURN_CURRENTSTATE.
+inline std::optional<GateType> getUniformGateType(const GateTypeMasks& masks) {
+	constexpr state_word_t ALL_BITS = ~(state_word_t)0;
+	const state_word_t used = masks.andMask | masks.orMask | masks.xorMask | masks.constantOnMask | masks.holdMask;
+	if (used == 0) return GateType::TICK_INPUT;
+	if (masks.holdMask == ALL_BITS) return GateType::DEFAULT_RETURN_CURRENTSTATE;
+	if (masks.constantOnMask == ALL_BITS) return GateType::CONSTANT_ON;
+	if (masks.invertMask != 0 && masks.invertMask != ALL_BITS) return std::nullopt;
+	const bool inverted = masks.invertMask == ALL_BITS;
+	if (masks.andMask == ALL_BITS) return inverted ? GateType::NAND : GateType::AND;
+	if (masks.orMask == ALL_BITS) return inverted ? GateType::NOR : GateType::OR;
+	if (masks.xorMask == ALL_BITS) return inverted ? GateType::XNOR : GateType::XOR;
+	return std::nullopt;
+}
+
+// Next states of a full word of gates that all have TYPE, only reads the counts that type needs.
+template<GateType TYPE>
+inline state_word_t computeUniformGateWord(const unsigned int* powered, const unsigned int* total, state_word_t current) {
+	if constexpr (TYPE == GateType::AND) {
+		const GateInputWords inputs = computeSelectedInputWords<true, false, false, true>(powered, total);
+		return inputs.allPowered & inputs.hasInputs;
+	} else if constexpr (TYPE == GateType::NAND) {
+		const GateInputWords inputs = computeSelectedInputWords<true, false, false, true>(powered, total);
+		return ~inputs.allPowered & inputs.hasInputs;
+	} else if constexpr (TYPE == GateType::OR) {
+		return computeSelectedInputWords<false, true, false, false>(powered, total).anyPowered;
+	} else if constexpr (TYPE == GateType::NOR) {
+		const GateInputWords inputs = computeSelectedInputWords<false, true, false, true>(powered, total);
+		return ~inputs.anyPowered & inputs.hasInputs;
+	} else if constexpr (TYPE == GateType::XOR) {
+		return computeSelectedInputWords<false, false, true, false>(powered, total).oddPowered;
+	} else if constexpr (TYPE == GateType::XNOR) {
+		const GateInputWords inputs = computeSelectedInputWords<false, false, true, true>(powered, total);
+		return ~inputs.oddPowered & inputs.hasInputs;
+	} else if constexpr (TYPE == GateType::CONSTANT_ON) {
+		return ~(state_word_t)0;
+	} else if constexpr (TYPE == GateType::TICK_INPUT) {
+		return 0;
+	} else {
+		return current;
+	}
+}
+
+// Next states of a full word of 64 gates. Words where every gate has the same type (compressGates
+// groups them that way) use the kernel for that type, the rest go through the masks.
+inline state_word_t computeGateWord(const GateTypeMasks& masks, const unsigned int* powered, const unsigned int* total, state_word_t current) {
+	const std::optional<GateType> uniformType = getUniformGateType(masks);
+	if (uniformType) {
+		switch (*uniformType) {
+		case GateType::AND: return computeUniformGateWord<GateType::AND>(powered, total, current);
+		case GateType::NAND: return computeUniformGateWord<GateType::NAND>(powered, total, current);
+		case GateType::OR: return computeUniformGateWord<GateType::OR>(powered, total, current);
+		case GateType::NOR: return computeUniformGateWord<GateType::NOR>(powered, total, current);
+		case GateType::XOR: return computeUniformGateWord<GateType::XOR>(powered, total, current);
+		case GateType::XNOR: return computeUniformGateWord<GateType::XNOR>(powered, total, current);
+		case GateType::CONSTANT_ON: return computeUniformGateWord<GateType::CONSTANT_ON>(powered, total, current);
+		case GateType::TICK_INPUT: return computeUniformGateWord<GateType::TICK_INPUT>(powered, total, current);
+		case GateType::NONE:
+		case GateType::DEFAULT_RETURN_CURRENTSTATE: return computeUniformGateWord<GateType::DEFAULT_RETURN_CURRENTSTATE>(powered, total, current);
+		}
+	}
+	return combineGateWord(masks, computeInputWords(powered, total), current);
+}
+
+#endif /* gateKernels_h */
@@ -1,19 +1,35 @@
 #include <stdexcept>
 
 #include <chrono>
+#include <bit>
+#include <array>
 
 #include "logicSimulator.h"
 
+static int64_t getMicroseconds() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static unsigned long long getNanoseconds() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 
 LogicSimulator::LogicSimulator()
 	:currentState(),
 	nextState(),
 	gateTypes(),
+	gateTypeMasks(),
 	gateInputs(),
 	gateOutputs(),
+	outputOffsets(),
+	outputTargets(),
 	gateInputCountTotal(),
 	gateInputCountPowered(),
-	numDecomissioned(0),
+	freeGates(),
+	dirtyGates(),
+	changedGates(),
+	gateIsDirty(),
 	ticksRun(0),
 	realTickrate(0),
 	running(true),
@@ -21,247 +37,905 @@ LogicSimulator::LogicSimulator()
 	isWaiting(false),
 	nextTick_us(0) {
 	simulationThread = std::thread(&LogicSimulator::simulationLoop, this);
+	// let the first (empty) tick finish so it cant race with gates being added
+	waitForPause();
+	realTickrate.store(ticksRun.exchange(0, std::memory_order_relaxed), std::memory_order_release);
 	tickrateMonitorThread = std::thread(&LogicSimulator::tickrateMonitor, this);
 }
 
 LogicSimulator::~LogicSimulator() {
-	running.store(false, std::memory_order_release);
-	// Signal to proceed in case thread is waiting
-	signalToProceed();
+	{
+		std::lock_guard<std::mutex> lock(pauseMutex);
+		running.store(false, std::memory_order_release);
+	}
+	// wake the threads in case they are parked
+	proceedCondition.notify_all();
+	monitorCondition.notify_all();
 	if (simulationThread.joinable()) {
 		simulationThread.join();
 	}
+	// workers are only released once the tick they might be in is over
+	stopWorkers();
+	// wake anyone still waiting on queued ticks
+	{
+		std::lock_guard<std::mutex> lock(tickRequestMutex);
+		for (auto& [target, promise] : tickRequests) {
+			promise.set_exception(std::make_exception_ptr(std::runtime_error("LogicSimulator destroyed before the queued ticks ran")));
+		}
+		tickRequests.clear();
+	}
+	// drop edits that never got applied
+	QueuedEdit* queuedEdit = editInbox.exchange(nullptr, std::memory_order_acquire);
+	while (queuedEdit) {
+		QueuedEdit* next = queuedEdit->next;
+		delete queuedEdit;
+		queuedEdit = next;
+	}
 	if (tickrateMonitorThread.joinable()) {
 		tickrateMonitorThread.join();
 	}
 }
 
 void LogicSimulator::initialize() {
-	std::fill(currentState.begin(), currentState.end(), false);
-	std::fill(nextState.begin(), nextState.end(), false);
+	stateEdited.store(true, std::memory_order_relaxed);
+	currentState.reset();
+	nextState.reset();
 	std::fill(gateInputCountPowered.begin(), gateInputCountPowered.end(), 0);
+	changedGates.clear();
+	markAllDirty();
 }
 
 block_id_t LogicSimulator::addGate(const GateType& gateType, bool allowSubstituteDecomissioned) {
-	if (allowSubstituteDecomissioned && numDecomissioned > 0) {
-		auto it = std::find(gateTypes.begin(), gateTypes.end(), GateType::NONE);
-		if (it != gateTypes.end()) {
-			const int index = it - gateTypes.begin();
-			gateTypes[index] = gateType;
-			gateInputCountTotal[index] = 0;
-			gateInputCountPowered[index] = 0;
-			currentState[index] = false;
-			nextState[index] = false;
-			--numDecomissioned;
-			return index;
-		}
+	stateEdited.store(true, std::memory_order_relaxed);
+	if (allowSubstituteDecomissioned && !freeGates.empty()) {
+		const block_id_t index = freeGates.back();
+		freeGates.pop_back();
+		gateTypes[index] = gateType;
+		setGateTypeMasks(index, gateType);
+		gateInputCountTotal[index] = 0;
+		gateInputCountPowered[index] = 0;
+		currentState.set(index, false);
+		nextState.set(index, false);
+		if (index < laneStates.size()) laneStates[index] = 0;
+		connectionsCompiled = false; // the levels depend on the type
+		markDirty(index);
+		return index;
 	}
 	gateTypes.push_back(gateType);
-	currentState.emplace_back(false);
-	nextState.emplace_back(false);
+	currentState.push_back(false);
+	nextState.push_back(false);
+	if (gateTypeMasks.size() < currentState.wordCount()) gateTypeMasks.emplace_back();
+	setGateTypeMasks(currentState.size() - 1, gateType);
 	gateInputs.emplace_back();
 	gateOutputs.emplace_back();
+	connectionsCompiled = false;
 	gateInputCountTotal.push_back(0);
 	gateInputCountPowered.push_back(0);
+	gateIsDirty.push_back(false);
+	markDirty(currentState.size() - 1);
 	return currentState.size() - 1;
 }
 
 void LogicSimulator::connectGates(block_id_t gate1, block_id_t gate2) {
+	stateEdited.store(true, std::memory_order_relaxed);
 	if (gate1 < 0 || gate1 >= currentState.size())
 		throw std::out_of_range("connectGates: gate1 index out of range");
 	if (gate2 < 0 || gate2 >= currentState.size())
 		throw std::out_of_range("connectGates: gate2 index out of range");
 
-	// check if the connection already exists
-	for (auto output : gateOutputs[gate1]) {
-		if (output == gate2) {
-			return;
-		}
-	}
+	if (findConnection(gate1, gate2) != -1) return;
 
-	gateOutputs[gate1].push_back(gate2);
-	gateInputs[gate2].push_back(gate1);
+	gateOutputs[gate1].push_back({gate2, (unsigned int)gateInputs[gate2].size()});
+	gateInputs[gate2].push_back({gate1, (unsigned int)gateOutputs[gate1].size() - 1});
+	connectionsCompiled = false;
 	++gateInputCountTotal[gate2];
 	if (nextState[gate1]) {
 		++gateInputCountPowered[gate2];
 	}
+	markDirty(gate2);
 }
 
 void LogicSimulator::disconnectGates(block_id_t gate1, block_id_t gate2) {
+	stateEdited.store(true, std::memory_order_relaxed);
 	if (gate1 < 0 || gate1 >= currentState.size())
-		throw std::out_of_range("connectGates: gate1 index out of range");
+		throw std::out_of_range("disconnectGates: gate1 index out of range");
 	if (gate2 < 0 || gate2 >= currentState.size())
-		throw std::out_of_range("connectGates: gate2 index out of range");
+		throw std::out_of_range("disconnectGates: gate2 index out of range");
 
-	for (auto it = gateOutputs[gate1].begin(); it != gateOutputs[gate1].end(); ++it) {
-		if (*it == gate2) {
-			gateOutputs[gate1].erase(it);
-			break;
-		}
-	}
+	const int connection = findConnection(gate1, gate2);
+	if (connection == -1) return;
+	const unsigned int outputIndex = connection;
+	connectionsCompiled = false;
+	const unsigned int inputIndex = gateOutputs[gate1][outputIndex].twin;
 
-	for (auto it = gateInputs[gate2].begin(); it != gateInputs[gate2].end(); ++it) {
-		if (*it == gate1) {
-			gateInputs[gate2].erase(it);
-			break;
-		}
+	// swap remove both sides and point the twins of the moved edges at their new spots
+	std::vector<GateEdge>& outputs = gateOutputs[gate1];
+	outputs[outputIndex] = outputs.back();
+	outputs.pop_back();
+	if (outputIndex < outputs.size()) {
+		gateInputs[outputs[outputIndex].gate][outputs[outputIndex].twin].twin = outputIndex;
+	}
+	std::vector<GateEdge>& inputs = gateInputs[gate2];
+	inputs[inputIndex] = inputs.back();
+	inputs.pop_back();
+	if (inputIndex < inputs.size()) {
+		gateOutputs[inputs[inputIndex].gate][inputs[inputIndex].twin].twin = inputIndex;
 	}
 
 	--gateInputCountTotal[gate2];
 	if (nextState[gate1]) {
 		--gateInputCountPowered[gate2];
 	}
+	markDirty(gate2);
+}
+
+int LogicSimulator::findConnection(block_id_t gate1, block_id_t gate2) const {
+	// scan whichever side is shorter, wide nets usually only have one wide side
+	const std::vector<GateEdge>& outputs = gateOutputs[gate1];
+	const std::vector<GateEdge>& inputs = gateInputs[gate2];
+	if (outputs.size() <= inputs.size()) {
+		for (unsigned int i = 0; i < outputs.size(); ++i) {
+			if (outputs[i].gate == gate2) return i;
+		}
+	} else {
+		for (const GateEdge& input : inputs) {
+			if (input.gate == gate1) return input.twin;
+		}
+	}
+	return -1;
 }
 
 void LogicSimulator::decomissionGate(block_id_t gate) {
+	stateEdited.store(true, std::memory_order_relaxed);
+	if (gateTypes[gate] == GateType::NONE) return; // already free
 	const auto inputs = gateInputs[gate];
-	for (auto input : inputs) {
-		disconnectGates(input, gate);
+	for (const GateEdge& input : inputs) {
+		disconnectGates(input.gate, gate);
 	}
 	const auto outputs = gateOutputs[gate];
-	for (auto output : outputs) {
-		disconnectGates(gate, output);
+	for (const GateEdge& output : outputs) {
+		disconnectGates(gate, output.gate);
 	}
 	gateTypes[gate] = GateType::NONE;
+	setGateTypeMasks(gate, GateType::NONE);
+	connectionsCompiled = false;
 	gateInputCountTotal[gate] = 0;
 	gateInputCountPowered[gate] = 0;
-	currentState[gate] = false;
-	nextState[gate] = false;
-	++numDecomissioned;
+	currentState.set(gate, false);
+	nextState.set(gate, false);
+	freeGates.push_back(gate);
 }
 
 std::unordered_map<block_id_t, block_id_t> LogicSimulator::compressGates() {
+	// new slots are grouped by type (counting sort, keeps the order within a type) so that
+	// whole words share a type and can use the specialized kernels
+	std::vector<block_id_t> gates;
+	gates.reserve(gateTypes.size());
+	for (block_id_t gate = 0; gate < gateTypes.size(); ++gate) {
+		gates.push_back(gate);
+	}
+	const std::vector<block_id_t> newIds = permuteGates(groupByType(gates));
 	std::unordered_map<block_id_t, block_id_t> gateMap;
-	int newGateIndex = 0;
-	for (auto i = 0; i < currentState.size(); ++i) {
-		if (gateTypes[i] != GateType::NONE) {
-			gateMap[i] = newGateIndex;
-			++newGateIndex;
+	gateMap.reserve(gateTypes.size());
+	for (block_id_t gate = 0; gate < newIds.size(); ++gate) {
+		if (newIds[gate] != INVALID_GATE) gateMap[gate] = newIds[gate];
+	}
+	return gateMap;
+}
+
+std::vector<block_id_t> LogicSimulator::getLocalityOrder() const {
+	// breadth first over the connections in both directions so the gates a gate drives and
+	// reads from get numbered close to it. each unvisited gate in id order starts a new search
+	std::vector<block_id_t> order;
+	order.reserve(gateTypes.size());
+	std::vector<uint8_t> visited(gateTypes.size(), false);
+	for (block_id_t start = 0; start < gateTypes.size(); ++start) {
+		if (visited[start] || gateTypes[start] == GateType::NONE) continue;
+		visited[start] = true;
+		order.push_back(start);
+		// order doubles as the queue
+		for (unsigned int next = order.size() - 1; next < order.size(); ++next) {
+			const block_id_t gate = order[next];
+			for (const GateEdge& output : gateOutputs[gate]) {
+				if (visited[output.gate]) continue;
+				visited[output.gate] = true;
+				order.push_back(output.gate);
+			}
+			for (const GateEdge& input : gateInputs[gate]) {
+				if (visited[input.gate]) continue;
+				visited[input.gate] = true;
+				order.push_back(input.gate);
+			}
 		}
 	}
+	// keep whole words of one type for the kernels, neighbours stay close within each type
+	return groupByType(order);
+}
 
-	for (auto i = 0; i < currentState.size(); ++i) {
-		if (gateTypes[i] == GateType::NONE) {
-			continue;
+std::vector<std::pair<block_id_t, block_id_t>> LogicSimulator::reorderGates(const std::vector<block_id_t>& order) {
+	const unsigned int liveGateCount = gateTypes.size() - freeGates.size();
+	if (order.size() != liveGateCount) {
+		throw std::invalid_argument("reorderGates: order must list every gate once");
+	}
+	std::vector<uint8_t> listed(gateTypes.size(), false);
+	for (block_id_t gate : order) {
+		if (gate >= gateTypes.size() || gateTypes[gate] == GateType::NONE || listed[gate]) {
+			throw std::invalid_argument("reorderGates: order must list every gate once");
 		}
-		const block_id_t newGateIndex = gateMap[i];
-		gateTypes[newGateIndex] = gateTypes[i];
-		currentState[newGateIndex] = currentState[i];
-		nextState[newGateIndex] = nextState[i];
-		gateInputs[newGateIndex] = gateInputs[i];
-		gateOutputs[newGateIndex] = gateOutputs[i];
-		gateInputCountTotal[newGateIndex] = gateInputCountTotal[i];
-		gateInputCountPowered[newGateIndex] = gateInputCountPowered[i];
+		listed[gate] = true;
+	}
+	const std::vector<block_id_t> newIds = permuteGates(order);
+	std::vector<std::pair<block_id_t, block_id_t>> moves;
+	for (block_id_t gate = 0; gate < newIds.size(); ++gate) {
+		if (newIds[gate] != INVALID_GATE && newIds[gate] != gate) moves.emplace_back(gate, newIds[gate]);
+	}
+	return moves;
+}
+
+std::vector<block_id_t> LogicSimulator::groupByType(const std::vector<block_id_t>& gates) const {
+	constexpr unsigned int TYPE_COUNT = 10;
+	std::array<unsigned int, TYPE_COUNT + 1> typeOffsets = {};
+	for (block_id_t gate : gates) {
+		if (gateTypes[gate] != GateType::NONE) ++typeOffsets[(unsigned int)gateTypes[gate] + 1];
+	}
+	for (unsigned int type = 0; type < TYPE_COUNT; ++type) {
+		typeOffsets[type + 1] += typeOffsets[type];
+	}
+	std::vector<block_id_t> grouped(typeOffsets[TYPE_COUNT]);
+	for (block_id_t gate : gates) {
+		if (gateTypes[gate] == GateType::NONE) continue;
+		grouped[typeOffsets[(unsigned int)gateTypes[gate]]++] = gate;
+	}
+	return grouped;
+}
 
+std::vector<block_id_t> LogicSimulator::permuteGates(const std::vector<block_id_t>& order) {
+	stateEdited.store(true, std::memory_order_relaxed);
+	const block_id_t newGateCount = order.size();
+	std::vector<block_id_t> newIds(gateTypes.size(), INVALID_GATE);
+	for (block_id_t gate = 0; gate < newGateCount; ++gate) {
+		newIds[order[gate]] = gate;
 	}
 
-	currentState.resize(newGateIndex);
-	nextState.resize(newGateIndex);
-	gateTypes.resize(newGateIndex);
-	gateInputs.resize(newGateIndex);
-	gateOutputs.resize(newGateIndex);
-	gateInputCountTotal.resize(newGateIndex);
-	gateInputCountPowered.resize(newGateIndex);
+	auto permute = [&order, newGateCount](auto& values) {
+		std::remove_reference_t<decltype(values)> permuted(newGateCount);
+		for (block_id_t gate = 0; gate < newGateCount; ++gate) {
+			permuted[gate] = std::move(values[order[gate]]);
+		}
+		values.swap(permuted);
+	};
+	auto permuteStates = [&order, newGateCount](StateVector& states) {
+		StateVector permuted;
+		permuted.resize(newGateCount);
+		for (block_id_t gate = 0; gate < newGateCount; ++gate) {
+			permuted.set(gate, states[order[gate]]);
+		}
+		states = std::move(permuted);
+	};
+	permuteStates(currentState);
+	permuteStates(nextState);
+	permute(gateInputs);
+	permute(gateOutputs);
+	permute(gateInputCountTotal);
+	permute(gateInputCountPowered);
+	permute(gateIsDirty);
+	if (!laneStates.empty()) {
+		laneStates.resize(gateTypes.size(), 0); // may be shorter than the gates before they are ticked
+		permute(laneStates);
+	}
+	permute(gateTypes);
+	connectionsCompiled = false;
+	gateTypeMasks.assign(currentState.wordCount(), GateTypeMasks());
+	for (block_id_t gate = 0; gate < gateTypes.size(); ++gate) {
+		setGateTypeMasks(gate, gateTypes[gate]);
+	}
 
-	for (auto i = 0; i < currentState.size(); ++i) {
-		for (block_id_t& input : gateInputs[i]) {
-			input = gateMap[input];
+	for (block_id_t i = 0; i < currentState.size(); ++i) {
+		// twins are positions within the lists so they stay valid
+		for (GateEdge& input : gateInputs[i]) {
+			input.gate = newIds[input.gate];
 		}
-		for (block_id_t& output : gateOutputs[i]) {
-			output = gateMap[output];
+		for (GateEdge& output : gateOutputs[i]) {
+			output.gate = newIds[output.gate];
 		}
 	}
 
-	numDecomissioned = 0;
+	// drop removed gates from the event lists
+	auto remapGateList = [&newIds](std::vector<block_id_t>& gates) {
+		unsigned int count = 0;
+		for (block_id_t gate : gates) {
+			if (newIds[gate] != INVALID_GATE) {
+				gates[count++] = newIds[gate];
+			}
+		}
+		gates.resize(count);
+	};
+	remapGateList(dirtyGates);
+	remapGateList(changedGates);
 
-	return gateMap;
+	freeGates.clear();
+
+	return newIds;
+}
+
+std::vector<std::pair<block_id_t, block_id_t>> LogicSimulator::fillGateHoles() {
+	std::vector<std::pair<block_id_t, block_id_t>> moves;
+	if (freeGates.empty()) return moves;
+	stateEdited.store(true, std::memory_order_relaxed);
+	const block_id_t newGateCount = gateTypes.size() - freeGates.size();
+	// removed gates can still be in the event lists, drop them before moved gates take their ids
+	// or the moved gate would be in a list twice and get its change propagated twice
+	auto dropFreeGates = [this](std::vector<block_id_t>& gates) {
+		std::erase_if(gates, [this](block_id_t gate) { return gateTypes[gate] == GateType::NONE; });
+	};
+	dropFreeGates(dirtyGates);
+	dropFreeGates(changedGates);
+	// the gates past the new end are exactly as many as the holes before it, so this only looks at
+	// about twice as many gates as were removed
+	block_id_t source = newGateCount;
+	for (block_id_t hole : freeGates) {
+		if (hole >= newGateCount) continue;
+		while (gateTypes[source] == GateType::NONE) ++source;
+		moveGate(source, hole);
+		moves.emplace_back(source, hole);
+		++source;
+	}
+
+	// the event lists are short compared to the circuit
+	if (!dirtyGates.empty() || !changedGates.empty()) {
+		std::unordered_map<block_id_t, block_id_t> moved(moves.begin(), moves.end());
+		auto remapGateList = [&moved, newGateCount](std::vector<block_id_t>& gates) {
+			unsigned int count = 0;
+			for (block_id_t gate : gates) {
+				if (gate < newGateCount) {
+					gates[count++] = gate;
+				} else if (auto it = moved.find(gate); it != moved.end()) {
+					gates[count++] = it->second;
+				}
+			}
+			gates.resize(count);
+		};
+		remapGateList(dirtyGates);
+		remapGateList(changedGates);
+	}
+
+	for (block_id_t gate = newGateCount; gate < gateTypes.size(); ++gate) {
+		setGateTypeMasks(gate, GateType::NONE); // clears the bits left in the last word
+	}
+	currentState.resize(newGateCount);
+	nextState.resize(newGateCount);
+	gateTypes.resize(newGateCount);
+	gateTypeMasks.resize(currentState.wordCount());
+	gateInputs.resize(newGateCount);
+	gateOutputs.resize(newGateCount);
+	gateInputCountTotal.resize(newGateCount);
+	gateInputCountPowered.resize(newGateCount);
+	gateIsDirty.resize(newGateCount);
+	if (laneStates.size() > newGateCount) laneStates.resize(newGateCount);
+	freeGates.clear();
+	connectionsCompiled = false;
+	return moves;
+}
+
+void LogicSimulator::moveGate(block_id_t from, block_id_t to) {
+	gateTypes[to] = gateTypes[from];
+	setGateTypeMasks(to, gateTypes[to]);
+	gateTypes[from] = GateType::NONE;
+	setGateTypeMasks(from, GateType::NONE);
+	currentState.set(to, currentState[from]);
+	nextState.set(to, nextState[from]);
+	gateInputCountTotal[to] = gateInputCountTotal[from];
+	gateInputCountPowered[to] = gateInputCountPowered[from];
+	gateIsDirty[to] = gateIsDirty[from];
+	if (to < laneStates.size()) laneStates[to] = from < laneStates.size() ? laneStates[from] : 0;
+	gateInputs[to] = std::move(gateInputs[from]);
+	gateOutputs[to] = std::move(gateOutputs[from]);
+	gateInputs[from].clear();
+	gateOutputs[from].clear();
+	// point the other side of every edge at the new id, a gate connected to itself is on both sides
+	for (GateEdge& input : gateInputs[to]) {
+		if (input.gate == from) input.gate = to;
+		gateOutputs[input.gate][input.twin].gate = to;
+	}
+	for (GateEdge& output : gateOutputs[to]) {
+		if (output.gate == from) output.gate = to;
+		gateInputs[output.gate][output.twin].gate = to;
+	}
+}
+
+void LogicSimulator::compileConnections() {
+	outputOffsets.resize(gateOutputs.size() + 1);
+	unsigned int connectionCount = 0;
+	for (block_id_t gate = 0; gate < gateOutputs.size(); ++gate) {
+		outputOffsets[gate] = connectionCount;
+		connectionCount += gateOutputs[gate].size();
+	}
+	outputOffsets.back() = connectionCount;
+	outputTargets.resize(connectionCount);
+	for (block_id_t gate = 0; gate < gateOutputs.size(); ++gate) {
+		for (unsigned int i = 0; i < gateOutputs[gate].size(); ++i) {
+			outputTargets[outputOffsets[gate] + i] = gateOutputs[gate][i].gate;
+		}
+	}
+	if (!laneStates.empty()) {
+		inputOffsets.resize(gateInputs.size() + 1);
+		inputSources.clear();
+		for (block_id_t gate = 0; gate < gateInputs.size(); ++gate) {
+			inputOffsets[gate] = inputSources.size();
+			for (const GateEdge& input : gateInputs[gate]) {
+				inputSources.push_back(input.gate);
+			}
+		}
+		inputOffsets.back() = inputSources.size();
+	}
+	if (workerCount > 1) partitionWorkers();
+	if (evaluationMode == EvaluationMode::LEVELIZED) compileLevels();
+	connectionsCompiled = true;
 }
 
 void LogicSimulator::propagatePowered() {
-	for (int i = 0; i < currentState.size(); ++i) {
-		int dif = nextState[i] - currentState[i];
-		if (dif) {
-			for (int output : gateOutputs[i]) {
-				gateInputCountPowered[output] += dif;
+	if (!connectionsCompiled) compileConnections();
+	// levelized already propagated while computing
+	if (evaluationMode == EvaluationMode::LEVELIZED) return;
+	if (evaluationMode == EvaluationMode::EVENT_DRIVEN) {
+		for (block_id_t gate : changedGates) {
+			int dif = nextState[gate] - currentState[gate];
+			for (unsigned int i = outputOffsets[gate]; i < outputOffsets[gate + 1]; ++i) {
+				gateInputCountPowered[outputTargets[i]] += dif;
+				markDirty(outputTargets[i]);
+			}
+		}
+		return;
+	}
+	if (usingWorkers()) {
+		runOnWorkers(WorkerTask::PROPAGATE);
+		return;
+	}
+	propagatePoweredWords<false>(0, currentState.wordCount());
+}
+
+static bool isLogicGate(GateType type) {
+	switch (type) {
+	case GateType::AND:
+	case GateType::OR:
+	case GateType::XOR:
+	case GateType::NAND:
+	case GateType::NOR:
+	case GateType::XNOR:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void LogicSimulator::compileLevels() {
+	const block_id_t gateCount = gateTypes.size();
+	// gates in feedback loops keep their delay, find them as tarjans strongly connected components
+	constexpr unsigned int UNVISITED = -1;
+	std::vector<unsigned int> visitIndex(gateCount, UNVISITED), lowLink(gateCount);
+	std::vector<uint8_t> onStack(gateCount, false), inCycle(gateCount, false);
+	std::vector<block_id_t> componentStack;
+	std::vector<std::pair<block_id_t, unsigned int>> callStack; // gate and the next connection to follow
+	unsigned int nextVisitIndex = 0;
+	auto visit = [&](block_id_t gate) {
+		visitIndex[gate] = lowLink[gate] = nextVisitIndex++;
+		componentStack.push_back(gate);
+		onStack[gate] = true;
+		callStack.emplace_back(gate, outputOffsets[gate]);
+	};
+	for (block_id_t root = 0; root < gateCount; ++root) {
+		if (visitIndex[root] != UNVISITED) continue;
+		visit(root);
+		while (!callStack.empty()) {
+			const block_id_t gate = callStack.back().first;
+			const unsigned int connection = callStack.back().second;
+			if (connection < outputOffsets[gate + 1]) {
+				++callStack.back().second;
+				const block_id_t output = outputTargets[connection];
+				if (output == gate) {
+					inCycle[gate] = true;
+				} else if (visitIndex[output] == UNVISITED) {
+					visit(output);
+				} else if (onStack[output]) {
+					lowLink[gate] = std::min(lowLink[gate], visitIndex[output]);
+				}
+				continue;
+			}
+			callStack.pop_back();
+			if (!callStack.empty()) {
+				const block_id_t parent = callStack.back().first;
+				lowLink[parent] = std::min(lowLink[parent], lowLink[gate]);
+			}
+			if (lowLink[gate] != visitIndex[gate]) continue;
+			// gate is the root of a component, anything bigger than one gate is a loop
+			const bool loop = componentStack.back() != gate;
+			block_id_t member;
+			do {
+				member = componentStack.back();
+				componentStack.pop_back();
+				onStack[member] = false;
+				if (loop) inCycle[member] = true;
+			} while (member != gate);
+		}
+	}
+
+	// order the rest of the logic gates by level with kahns algorithm
+	delayedGates.clear();
+	levelizedGates.clear();
+	std::vector<unsigned int> pendingInputs(gateCount, 0);
+	auto isLevelized = [&](block_id_t gate) { return !inCycle[gate] && isLogicGate(gateTypes[gate]); };
+	for (block_id_t gate = 0; gate < gateCount; ++gate) {
+		if (gateTypes[gate] == GateType::NONE) continue;
+		if (!isLevelized(gate)) {
+			delayedGates.push_back(gate);
+			continue;
+		}
+		for (unsigned int i = outputOffsets[gate]; i < outputOffsets[gate + 1]; ++i) {
+			if (isLevelized(outputTargets[i])) ++pendingInputs[outputTargets[i]];
+		}
+	}
+	for (block_id_t gate = 0; gate < gateCount; ++gate) {
+		if (isLevelized(gate) && pendingInputs[gate] == 0) levelizedGates.push_back(gate);
+	}
+	for (unsigned int next = 0; next < levelizedGates.size(); ++next) {
+		const block_id_t gate = levelizedGates[next];
+		for (unsigned int i = outputOffsets[gate]; i < outputOffsets[gate + 1]; ++i) {
+			const block_id_t output = outputTargets[i];
+			if (isLevelized(output) && --pendingInputs[output] == 0) levelizedGates.push_back(output);
+		}
+	}
+}
+
+inline void LogicSimulator::propagateGate(block_id_t gate) {
+	if (nextState[gate] == currentState[gate]) return;
+	const int dif = nextState[gate] ? 1 : -1;
+	for (unsigned int i = outputOffsets[gate]; i < outputOffsets[gate + 1]; ++i) {
+		gateInputCountPowered[outputTargets[i]] += dif;
+	}
+}
+
+void LogicSimulator::computeNextStateLevelized() {
+	// delayed gates only see the last tick
+	for (block_id_t gate : delayedGates) {
+		nextState.set(gate, computeGateState(gate));
+	}
+	for (block_id_t gate : delayedGates) {
+		propagateGate(gate);
+	}
+	// every input of a levelized gate is final by the time it is reached so its change is passed on right away
+	for (block_id_t gate : levelizedGates) {
+		nextState.set(gate, computeGateState(gate));
+		propagateGate(gate);
+	}
+}
+
+template<bool ATOMIC>
+void LogicSimulator::propagatePoweredWords(unsigned int firstWord, unsigned int lastWord) {
+	for (unsigned int word = firstWord; word < lastWord; ++word) {
+		state_word_t changed = nextState.getWord(word) ^ currentState.getWord(word);
+		while (changed) {
+			const block_id_t gate = word * STATE_WORD_BITS + std::countr_zero(changed);
+			changed &= changed - 1;
+			int dif = nextState[gate] ? 1 : -1;
+			for (unsigned int i = outputOffsets[gate]; i < outputOffsets[gate + 1]; ++i) {
+				if constexpr (ATOMIC) {
+					// outputs can be in other workers ranges
+					std::atomic_ref<unsigned int>(gateInputCountPowered[outputTargets[i]]).fetch_add(dif, std::memory_order_relaxed);
+				} else {
+					gateInputCountPowered[outputTargets[i]] += dif;
+				}
 			}
 		}
 	}
 }
 
 void LogicSimulator::swapStates() {
-	std::swap(currentState, nextState);
+	// copy instead of swapping so nextState stays valid for edits made between ticks
+	if (evaluationMode == EvaluationMode::EVENT_DRIVEN) {
+		for (block_id_t gate : changedGates) {
+			currentState.set(gate, nextState[gate]);
+		}
+		changedGates.clear();
+		return;
+	}
+	currentState = nextState;
+}
+
+inline logic_state_t LogicSimulator::computeGateState(block_id_t gate) const {
+	const unsigned int word = gate / STATE_WORD_BITS;
+	const unsigned int bit = gate % STATE_WORD_BITS;
+	const GateInputWords inputs = computeInputWordsScalar(&gateInputCountPowered[gate], &gateInputCountTotal[gate], 1);
+	const state_word_t current = currentState.getWord(word) >> bit;
+	const GateTypeMasks& masks = gateTypeMasks[word];
+	const GateTypeMasks gateMasks = {
+		masks.andMask >> bit, masks.orMask >> bit, masks.xorMask >> bit,
+		masks.invertMask >> bit, masks.constantOnMask >> bit, masks.holdMask >> bit
+	};
+	return combineGateWord(gateMasks, inputs, current) & 1;
 }
 
 void LogicSimulator::computeNextState() {
-	for (block_id_t gate = 0; gate < nextState.size(); ++gate) {
-		unsigned int powered = gateInputCountPowered[gate];
-		unsigned int type = (unsigned int)gateTypes[gate];
-		if (type > 7) { // and + nand
-			unsigned int gc = gateInputCountTotal[gate];
-			nextState[gate] = ((type & 1) ^ (powered == gc)) && gc;
-		} else if (type > 5) { // nor + xnor
-			unsigned int gc = gateInputCountTotal[gate];
-			nextState[gate] = (!((powered & 1) || (powered && (type & 1)))) && gc;
-		} else if (type > 3) { // or + xor
-			nextState[gate] = (powered & 1) || (powered && (type & 1));
-		} else if (type > 1) { // tick_input + constant_on
-			nextState[gate] = type & 1;
-		} else { // stays the same
-			nextState[gate] = currentState[gate];
+	stateEdited.store(false, std::memory_order_relaxed);
+	if (!connectionsCompiled) compileConnections();
+	if (evaluationMode == EvaluationMode::EVENT_DRIVEN) {
+		for (block_id_t gate : dirtyGates) {
+			gateIsDirty[gate] = false;
+			const logic_state_t state = computeGateState(gate);
+			nextState.set(gate, state);
+			if (state != currentState[gate]) {
+				changedGates.push_back(gate);
+			}
+		}
+		dirtyGates.clear();
+		return;
+	}
+	if (evaluationMode == EvaluationMode::LEVELIZED) {
+		computeNextStateLevelized();
+		return;
+	}
+	if (usingWorkers()) {
+		runOnWorkers(WorkerTask::COMPUTE);
+		return;
+	}
+	computeNextStateWords(0, nextState.wordCount());
+}
+
+void LogicSimulator::computeNextStateWords(unsigned int firstWord, unsigned int lastWord) {
+	const unsigned int fullWords = std::min(lastWord, nextState.size() / STATE_WORD_BITS);
+	for (unsigned int word = firstWord; word < fullWords; ++word) {
+		const unsigned int first = word * STATE_WORD_BITS;
+		nextState.setWord(word, computeGateWord(gateTypeMasks[word], &gateInputCountPowered[first], &gateInputCountTotal[first], currentState.getWord(word)));
+	}
+	// the last word may not be full
+	const unsigned int remaining = nextState.size() % STATE_WORD_BITS;
+	if (remaining && fullWords < lastWord) {
+		const unsigned int first = fullWords * STATE_WORD_BITS;
+		const GateInputWords inputs = computeInputWordsScalar(&gateInputCountPowered[first], &gateInputCountTotal[first], remaining);
+		nextState.setWord(fullWords, combineGateWord(gateTypeMasks[fullWords], inputs, currentState.getWord(fullWords)));
+	}
+}
+
+void LogicSimulator::setLaneStates(block_id_t gate, lane_word_t states) {
+	if (gate >= currentState.size())
+		throw std::out_of_range("setLaneStates: gate index out of range");
+	laneStates.resize(currentState.size(), 0);
+	laneStates[gate] = states;
+}
+
+lane_word_t LogicSimulator::getLaneStates(block_id_t gate) const {
+	if (gate >= currentState.size())
+		throw std::out_of_range("getLaneStates: gate index out of range");
+	return gate < laneStates.size() ? laneStates[gate] : 0;
+}
+
+void LogicSimulator::resetLanes() {
+	std::fill(laneStates.begin(), laneStates.end(), 0);
+}
+
+void LogicSimulator::simulateLaneTicks(unsigned int n) {
+	static const std::array<GateTypeMasks, 10> laneTypeMasks = []() {
+		std::array<GateTypeMasks, 10> masks;
+		for (unsigned int type = 0; type < masks.size(); ++type) {
+			masks[type] = broadcastGateType((GateType)type);
+		}
+		return masks;
+	}();
+
+	const block_id_t gateCount = currentState.size();
+	if (gateCount == 0) return;
+	laneStates.resize(gateCount, 0);
+	nextLaneStates.resize(gateCount);
+	// the input lists are only built once lanes are in use
+	if (!connectionsCompiled || inputOffsets.size() != gateCount + 1) compileConnections();
+
+	for (unsigned int tick = 0; tick < n; ++tick) {
+		for (block_id_t gate = 0; gate < gateCount; ++gate) {
+			// the predicates are per lane here instead of per gate
+			GateInputWords inputs;
+			inputs.allPowered = ~(lane_word_t)0;
+			for (unsigned int i = inputOffsets[gate]; i < inputOffsets[gate + 1]; ++i) {
+				const lane_word_t input = laneStates[inputSources[i]];
+				inputs.allPowered &= input;
+				inputs.anyPowered |= input;
+				inputs.oddPowered ^= input;
+			}
+			inputs.hasInputs = inputOffsets[gate] == inputOffsets[gate + 1] ? 0 : ~(lane_word_t)0;
+			nextLaneStates[gate] = combineGateWord(laneTypeMasks[(unsigned int)gateTypes[gate]], inputs, laneStates[gate]);
+		}
+		laneStates.swap(nextLaneStates);
+	}
+}
+
+void LogicSimulator::setWorkerCount(unsigned int count) {
+	if (count == 0) count = 1;
+	if (count == workerCount) return;
+	stopWorkers();
+	workerCount = count;
+	if (workerCount > 1) {
+		workerBarrier = std::make_unique<std::barrier<>>(workerCount);
+		// the thread that runs the tick is worker 0
+		for (unsigned int worker = 1; worker < workerCount; ++worker) {
+			workers.emplace_back(&LogicSimulator::workerLoop, this, worker);
 		}
 	}
+	connectionsCompiled = false; // rebuilds the partitions
+}
+
+void LogicSimulator::stopWorkers() {
+	if (workers.empty()) return;
+	workerTask = WorkerTask::STOP;
+	workerBarrier->arrive_and_wait();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+	workerBarrier.reset();
+}
+
+void LogicSimulator::partitionWorkers() {
+	// balance the words between workers by the gates and connections they have to go through
+	const unsigned int wordCount = currentState.wordCount();
+	const unsigned long long totalWork = (unsigned long long)currentState.size() + outputTargets.size();
+	partitionWords.assign(workerCount + 1, wordCount);
+	partitionWords[0] = 0;
+	unsigned int worker = 1;
+	for (unsigned int word = 0; word < wordCount && worker < workerCount; ++word) {
+		const block_id_t gateEnd = std::min((word + 1) * STATE_WORD_BITS, currentState.size());
+		const unsigned long long work = (unsigned long long)gateEnd + outputOffsets[gateEnd];
+		if (work * workerCount >= totalWork * worker) {
+			partitionWords[worker++] = word + 1;
+		}
+	}
+}
+
+void LogicSimulator::runOnWorkers(WorkerTask task) {
+	workerTask = task;
+	workerBarrier->arrive_and_wait();
+	runWorkerTask(0);
+	workerBarrier->arrive_and_wait();
+}
+
+void LogicSimulator::runWorkerTask(unsigned int worker) {
+	const unsigned int firstWord = partitionWords[worker];
+	const unsigned int lastWord = partitionWords[worker + 1];
+	switch (workerTask) {
+	case WorkerTask::COMPUTE: computeNextStateWords(firstWord, lastWord); break;
+	case WorkerTask::PROPAGATE: propagatePoweredWords<true>(firstWord, lastWord); break;
+	case WorkerTask::STOP: break;
+	}
+}
+
+void LogicSimulator::workerLoop(unsigned int worker) {
+	while (true) {
+		workerBarrier->arrive_and_wait();
+		if (workerTask == WorkerTask::STOP) return;
+		runWorkerTask(worker);
+		workerBarrier->arrive_and_wait();
+	}
+}
+
+inline void LogicSimulator::setGateTypeMasks(block_id_t gate, GateType type) {
+	gateTypeMasks[gate / STATE_WORD_BITS].setType(gate % STATE_WORD_BITS, type);
+}
+
+inline void LogicSimulator::markDirty(block_id_t gate) {
+	if (evaluationMode != EvaluationMode::EVENT_DRIVEN || gateIsDirty[gate]) return;
+	gateIsDirty[gate] = true;
+	dirtyGates.push_back(gate);
+}
+
+void LogicSimulator::markAllDirty() {
+	dirtyGates.clear();
+	if (evaluationMode != EvaluationMode::EVENT_DRIVEN) {
+		std::fill(gateIsDirty.begin(), gateIsDirty.end(), false);
+		return;
+	}
+	dirtyGates.reserve(currentState.size());
+	for (block_id_t gate = 0; gate < currentState.size(); ++gate) {
+		gateIsDirty[gate] = true;
+		dirtyGates.push_back(gate);
+	}
+}
+
+void LogicSimulator::setEvaluationMode(EvaluationMode mode) {
+	stateEdited.store(true, std::memory_order_relaxed);
+	if (mode == evaluationMode) return;
+	evaluationMode = mode;
+	changedGates.clear();
+	if (mode == EvaluationMode::LEVELIZED) connectionsCompiled = false; // builds the levels
+	if (mode == EvaluationMode::EVENT_DRIVEN) {
+		// the sweep may have left next states that have not been swapped in yet
+		for (block_id_t gate = 0; gate < currentState.size(); ++gate) {
+			if (currentState[gate] != nextState[gate]) {
+				changedGates.push_back(gate);
+			}
+		}
+	}
+	markAllDirty();
 }
 
 void LogicSimulator::setState(block_id_t gate, logic_state_t state) {
+	stateEdited.store(true, std::memory_order_relaxed);
 	if (gate < 0 || gate >= currentState.size())
 		throw std::out_of_range("setState: gate index out of range");
-	currentState[gate] = state;
+	currentState.set(gate, state);
+	markDirty(gate);
 	if (state != nextState[gate]) {
-		nextState[gate] = state;
+		nextState.set(gate, state);
 		if (state) {
-			for (int output : gateOutputs[gate]) {
-				++gateInputCountPowered[output];
+			for (const GateEdge& output : gateOutputs[gate]) {
+				++gateInputCountPowered[output.gate];
+				markDirty(output.gate);
 			}
 		} else {
-			for (int output : gateOutputs[gate]) {
-				--gateInputCountPowered[output];
+			for (const GateEdge& output : gateOutputs[gate]) {
+				--gateInputCountPowered[output.gate];
+				markDirty(output.gate);
 			}
 		}
 	}
 }
 
 void LogicSimulator::clearGates() {
+	stateEdited.store(true, std::memory_order_relaxed);
 	currentState.clear();
 	nextState.clear();
 	gateTypes.clear();
+	gateTypeMasks.clear();
 	gateInputs.clear();
 	gateOutputs.clear();
+	connectionsCompiled = false;
 	gateInputCountTotal.clear();
 	gateInputCountPowered.clear();
-	numDecomissioned = 0;
+	gateIsDirty.clear();
+	dirtyGates.clear();
+	changedGates.clear();
+	freeGates.clear();
+	laneStates.clear();
+	nextLaneStates.clear();
+	inputOffsets.clear();
+	inputSources.clear();
 }
 
 void LogicSimulator::reserveGates(block_id_t numGates) {
 	currentState.reserve(numGates);
 	nextState.reserve(numGates);
 	gateTypes.reserve(numGates);
+	gateTypeMasks.reserve(numGates / STATE_WORD_BITS + 1);
 	gateInputs.reserve(numGates);
 	gateOutputs.reserve(numGates);
 	gateInputCountTotal.reserve(numGates);
 	gateInputCountPowered.reserve(numGates);
+	gateIsDirty.reserve(numGates);
 }
 
 void LogicSimulator::simulateNTicks(unsigned int n) {
-	for (int i = 0; i < n; ++i) {
+	for (unsigned int i = 0; i < n; ++i) {
 		computeNextState();
 		propagatePowered();
 		swapStates();
 	}
+	publishSnapshot();
+}
+
+size_t LogicSimulator::getMemoryUsage() const {
+	auto vectorBytes = [](const auto& values) { return values.capacity() * sizeof(values[0]); };
+	size_t bytes = currentState.memoryUsage() + nextState.memoryUsage();
+	bytes += vectorBytes(gateTypes) + vectorBytes(gateTypeMasks);
+	bytes += vectorBytes(gateInputs) + vectorBytes(gateOutputs);
+	for (block_id_t gate = 0; gate < gateInputs.size(); ++gate) {
+		bytes += vectorBytes(gateInputs[gate]) + vectorBytes(gateOutputs[gate]);
+	}
+	bytes += vectorBytes(outputOffsets) + vectorBytes(outputTargets);
+	bytes += vectorBytes(gateInputCountTotal) + vectorBytes(gateInputCountPowered);
+	bytes += vectorBytes(freeGates) + vectorBytes(dirtyGates) + vectorBytes(changedGates) + vectorBytes(gateIsDirty);
+	bytes += vectorBytes(delayedGates) + vectorBytes(levelizedGates);
+	return bytes;
 }
 
 void LogicSimulator::debugPrint() {
 	std::cout << "ID:        ";
-	for (int i = 0; i < currentState.size(); ++i) {
+	for (block_id_t i = 0; i < currentState.size(); ++i) {
 		std::cout << i << " ";
 	}
 	std::cout << "\nGate type: ";
@@ -270,17 +944,17 @@ void LogicSimulator::debugPrint() {
 	}
 	std::cout << "\nOutputs:   ";
 	// find longest number of updates
-	int maxOutputs = 0;
+	size_t maxOutputs = 0;
 	for (auto outputs : gateOutputs) {
-		maxOutputs = std::max(maxOutputs, static_cast<int>(outputs.size()));
+		maxOutputs = std::max(maxOutputs, outputs.size());
 	}
-	for (int i = 0; i < maxOutputs; ++i) {
+	for (size_t i = 0; i < maxOutputs; ++i) {
 		if (i != 0) {
 			std::cout << "           ";
 		}
 		for (auto outputs : gateOutputs) {
 			if (i < outputs.size()) {
-				std::cout << outputs[i] << " ";
+				std::cout << outputs[i].gate << " ";
 			} else {
 				std::cout << "  ";
 			}
@@ -298,59 +972,280 @@ void LogicSimulator::debugPrint() {
 		std::cout << inputCount << " ";
 	}
 	std::cout << "\nC State:   ";
-	for (auto state : currentState) {
-		std::cout << state << " ";
+	for (block_id_t gate = 0; gate < currentState.size(); ++gate) {
+		std::cout << currentState[gate] << " ";
 	}
 	std::cout << "\nN State:   ";
-	for (auto state : nextState) {
-		std::cout << state << " ";
+	for (block_id_t gate = 0; gate < nextState.size(); ++gate) {
+		std::cout << nextState[gate] << " ";
 	}
 	std::cout << "\n" << std::endl;
 }
 
 void LogicSimulator::simulationLoop() {
 	while (running.load(std::memory_order_acquire)) {
+		unsigned long long tickStart_ns = 0, computed_ns = 0, propagated_ns = 0;
+		if constexpr (METRICS_ENABLED) tickStart_ns = getNanoseconds();
 		computeNextState();
+		if constexpr (METRICS_ENABLED) computed_ns = getNanoseconds();
 		propagatePowered();
+		if constexpr (METRICS_ENABLED) propagated_ns = getNanoseconds();
 		++ticksRun;
 
-		bool waiting = false;
-
-		while (
-			!proceedFlag.load(std::memory_order_acquire) &&
-			running.load(std::memory_order_acquire) ||
-			!waiting ||
-			std::chrono::duration_cast<std::chrono::microseconds>(
-				std::chrono::system_clock::now().time_since_epoch()
-			).count() < nextTick_us.load(std::memory_order_acquire)
-		) {
-			if (!waiting) {
-				isWaiting.store(true, std::memory_order_release);
-				waiting = true;
+		bool fastTick = false;
+		bool steady = isSteady();
+		// ticks skipped while steady are still counted at the target tickrate
+		bool idling = false;
+		int64_t idleCounted_us = 0;
+		unsigned long long idleTickCredit = 0; // in tick microseconds per minute
+		{
+			// park between ticks until we are allowed to proceed and the next tick is due
+			std::unique_lock<std::mutex> lock(pauseMutex);
+			isWaiting.store(true, std::memory_order_release);
+			waitingCondition.notify_all();
+			while (running.load(std::memory_order_acquire)) {
+				// anything changed directly while we were parked
+				if (steady && stateEdited.load(std::memory_order_relaxed)) steady = false;
+				if (editInbox.load(std::memory_order_acquire)) {
+					// no one else may touch the simulator while the edits run
+					isWaiting.store(false, std::memory_order_release);
+					lock.unlock();
+					applyQueuedEdits();
+					lock.lock();
+					isWaiting.store(true, std::memory_order_release);
+					waitingCondition.notify_all();
+					idling = false;
+					continue;
+				}
+				// queued ticks skip the pause and the tickrate
+				const unsigned long long fastTicksLeft = fastTicksRequested.load(std::memory_order_acquire) - fastTicksRun.load(std::memory_order_relaxed);
+				if (fastTicksLeft) {
+					if (steady) {
+						// they would all change nothing
+						ticksRun.fetch_add(fastTicksLeft, std::memory_order_relaxed);
+						finishFastTicks(fastTicksLeft);
+						continue;
+					}
+					fastTick = true;
+					break;
+				}
+				if (idleTaskPending && (steady || !proceedFlag.load(std::memory_order_acquire))) {
+					// parked after edits, same rules as an edit
+					idleTaskPending = false;
+					isWaiting.store(false, std::memory_order_release);
+					lock.unlock();
+					idleTask();
+					lock.lock();
+					isWaiting.store(true, std::memory_order_release);
+					waitingCondition.notify_all();
+					continue;
+				}
+				if (!proceedFlag.load(std::memory_order_acquire)) {
+					idling = false;
+					proceedCondition.wait(lock);
+					continue;
+				}
+				if (steady) {
+					const int64_t now_us = getMicroseconds();
+					const unsigned long long target = targetTickrate.load(std::memory_order_acquire);
+					const int64_t period_us = 60000000 / target;
+					if (period_us > 0) {
+						// follow the same schedule the paced ticks would have
+						const int64_t nextTick = nextTick_us.load(std::memory_order_acquire);
+						if (now_us >= nextTick) {
+							const int64_t ticks = (now_us - nextTick) / period_us + 1;
+							ticksRun.fetch_add(ticks, std::memory_order_relaxed);
+							nextTick_us.store(nextTick + ticks * period_us, std::memory_order_release);
+						}
+					} else if (idling) {
+						// faster than the clock can pace, count at the target rate
+						idleTickCredit += (now_us - idleCounted_us) * target;
+						const unsigned long long ticks = idleTickCredit / 60000000;
+						idleTickCredit -= ticks * 60000000;
+						ticksRun.fetch_add(ticks, std::memory_order_relaxed);
+					}
+					idling = true;
+					idleCounted_us = now_us;
+					// only wakes up to keep the tickrate counted, anything that could change the state notifies
+					proceedCondition.wait_for(lock, IDLE_WAKE_INTERVAL);
+					continue;
+				}
+				const std::chrono::system_clock::time_point nextTick(
+					std::chrono::microseconds(nextTick_us.load(std::memory_order_acquire))
+				);
+				if (std::chrono::system_clock::now() >= nextTick) break;
+				proceedCondition.wait_until(lock, nextTick);
 			}
-			std::this_thread::yield();
-		}
-
-		if (waiting) {
 			isWaiting.store(false, std::memory_order_release);
 		}
 
 		if (!running.load(std::memory_order_acquire)) {
 			break;
 		}
-		swapStates();
+		if constexpr (METRICS_ENABLED) {
+			// edits while parked can change next, so count right before it lands
+			const unsigned long long toggled = countChangedGates();
+			const unsigned long long swapStart_ns = getNanoseconds();
+			swapStates();
+			const unsigned long long swapped_ns = getNanoseconds();
+			metrics.recordPauseWait(swapStart_ns - propagated_ns);
+			metrics.recordTick(computed_ns - tickStart_ns, propagated_ns - computed_ns, (propagated_ns - tickStart_ns) + (swapped_ns - swapStart_ns), toggled);
+		} else {
+			swapStates();
+		}
+		if (fastTick) {
+			finishFastTicks(1);
+			continue;
+		}
+		publishSnapshot();
 		// get target tickrate and add to counter
 		const unsigned long long int target = targetTickrate.load(std::memory_order_acquire);
 		nextTick_us.fetch_add(60000000 / target, std::memory_order_release);
 	}
 }
 
+std::future<void> LogicSimulator::queueTicks(unsigned long long n) {
+	std::promise<void> promise;
+	std::future<void> future = promise.get_future();
+	if (n == 0) {
+		promise.set_value();
+		return future;
+	}
+	{
+		// requested under the lock so the requests stay sorted by their target
+		std::lock_guard<std::mutex> lock(tickRequestMutex);
+		const unsigned long long target = fastTicksRequested.fetch_add(n, std::memory_order_acq_rel) + n;
+		tickRequests.emplace_back(target, std::move(promise));
+	}
+	{
+		std::lock_guard<std::mutex> lock(pauseMutex);
+	}
+	proceedCondition.notify_one();
+	return future;
+}
+
+void LogicSimulator::finishFastTicks(unsigned long long count) {
+	const unsigned long long ran = fastTicksRun.fetch_add(count, std::memory_order_acq_rel) + count;
+	bool finishedRequest = false;
+	{
+		std::lock_guard<std::mutex> lock(tickRequestMutex);
+		while (!tickRequests.empty() && tickRequests.front().first <= ran) {
+			if (!finishedRequest) publishSnapshot(); // before the future is ready so the caller reads the final states
+			finishedRequest = true;
+			tickRequests.front().second.set_value();
+			tickRequests.pop_front();
+		}
+	}
+	if (!finishedRequest && ran % FAST_TICK_PUBLISH_INTERVAL < count) {
+		publishSnapshot();
+	}
+	if (ran == fastTicksRequested.load(std::memory_order_acquire)) {
+		// dont make up for the time spent fast forwarding
+		nextTick_us.store(getMicroseconds(), std::memory_order_release);
+	}
+}
+
+unsigned long long LogicSimulator::countChangedGates() const {
+	if (evaluationMode == EvaluationMode::EVENT_DRIVEN) return changedGates.size();
+	unsigned long long changed = 0;
+	for (unsigned int word = 0; word < nextState.wordCount(); ++word) {
+		changed += std::popcount(nextState.getWord(word) ^ currentState.getWord(word));
+	}
+	return changed;
+}
+
+SimulatorMetrics LogicSimulator::getMetrics() const {
+	SimulatorMetrics simulatorMetrics = metrics.read();
+	const unsigned long long applied = editsApplied.load(std::memory_order_acquire);
+	simulatorMetrics.editQueueDepth = editsQueued.load(std::memory_order_acquire) - applied;
+	return simulatorMetrics;
+}
+
+bool LogicSimulator::isSteady() const {
+	if (stateEdited.load(std::memory_order_relaxed)) return false;
+	if (evaluationMode == EvaluationMode::EVENT_DRIVEN) return changedGates.empty() && dirtyGates.empty();
+	return nextState == currentState;
+}
+
+std::future<void> LogicSimulator::queueEdit(std::function<void()> edit) {
+	QueuedEdit* queuedEdit = new QueuedEdit{std::move(edit), editInbox.load(std::memory_order_relaxed), std::promise<void>()};
+	std::future<void> done = queuedEdit->done.get_future();
+	editsQueued.fetch_add(1, std::memory_order_acq_rel);
+	while (!editInbox.compare_exchange_weak(queuedEdit->next, queuedEdit, std::memory_order_release, std::memory_order_relaxed)) {
+		// a failed exchange put the current head in queuedEdit->next, try again on top of it
+	}
+	{
+		// the lock makes sure the thread cant miss the notify between checking the inbox and parking
+		std::lock_guard<std::mutex> lock(pauseMutex);
+	}
+	proceedCondition.notify_one();
+	return done;
+}
+
+void LogicSimulator::flushEdits() {
+	const unsigned long long target = editsQueued.load(std::memory_order_acquire);
+	if (editsApplied.load(std::memory_order_acquire) >= target) return;
+	unsigned long long waitStart_ns = 0;
+	if constexpr (METRICS_ENABLED) waitStart_ns = getNanoseconds();
+	std::unique_lock<std::mutex> lock(pauseMutex);
+	waitingCondition.wait(lock, [this, target] { return editsApplied.load(std::memory_order_acquire) >= target; });
+	if constexpr (METRICS_ENABLED) metrics.recordReadWait(getNanoseconds() - waitStart_ns);
+}
+
+void LogicSimulator::setIdleTask(std::function<void()> task) {
+	queueEdit([this, task = std::move(task)]() {
+		idleTask = task;
+	});
+}
+
+void LogicSimulator::applyQueuedEdits() {
+	// the stack is newest first, reverse it to apply in order
+	QueuedEdit* queuedEdit = editInbox.exchange(nullptr, std::memory_order_acquire);
+	QueuedEdit* ordered = nullptr;
+	while (queuedEdit) {
+		QueuedEdit* next = queuedEdit->next;
+		queuedEdit->next = ordered;
+		ordered = queuedEdit;
+		queuedEdit = next;
+	}
+	unsigned long long applied = 0;
+	while (ordered) {
+		// a bad edit shouldnt take down the simulation thread, whoever queued it gets the exception
+		try {
+			ordered->apply();
+			ordered->done.set_value();
+		} catch (...) {
+			ordered->done.set_exception(std::current_exception());
+		}
+		QueuedEdit* next = ordered->next;
+		delete ordered;
+		ordered = next;
+		++applied;
+	}
+	publishSnapshot();
+	metrics.recordEditBatch(applied);
+	idleTaskPending = (bool)idleTask;
+	std::lock_guard<std::mutex> lock(pauseMutex);
+	editsApplied.fetch_add(applied, std::memory_order_acq_rel);
+}
+
 void LogicSimulator::signalToPause() {
+	std::lock_guard<std::mutex> lock(pauseMutex);
 	proceedFlag.store(false, std::memory_order_release);
 }
 
+void LogicSimulator::waitForPause() {
+	std::unique_lock<std::mutex> lock(pauseMutex);
+	proceedFlag.store(false, std::memory_order_release);
+	waitingCondition.wait(lock, [this] { return isWaiting.load(std::memory_order_acquire); });
+}
+
 void LogicSimulator::signalToProceed() {
-	proceedFlag.store(true, std::memory_order_release);
+	{
+		std::lock_guard<std::mutex> lock(pauseMutex);
+		proceedFlag.store(true, std::memory_order_release);
+	}
+	proceedCondition.notify_one();
 }
 
 bool LogicSimulator::threadIsWaiting() const {
@@ -358,11 +1253,13 @@ bool LogicSimulator::threadIsWaiting() const {
 }
 
 void LogicSimulator::tickrateMonitor() {
+	std::unique_lock<std::mutex> lock(monitorMutex);
 	while (running.load(std::memory_order_acquire)) {
+		// returns early when the simulator is destroyed
+		if (monitorCondition.wait_for(lock, std::chrono::seconds(1), [this] { return !running.load(std::memory_order_acquire); })) break;
 		const long long int ticks = ticksRun.exchange(0, std::memory_order_relaxed);
 		realTickrate.store(ticks, std::memory_order_release);
 		// std::cout << "Tickrate: " << ticks << std::endl;
-		std::this_thread::sleep_for(std::chrono::seconds(1));
 	}
 }
 
@@ -372,6 +1269,10 @@ void LogicSimulator::setTargetTickrate(unsigned long long tickrate) {
 }
 
 void LogicSimulator::triggerNextTickReset() {
-	nextTick_us.store(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count(), std::memory_order_release);
-
+	{
+		std::lock_guard<std::mutex> lock(pauseMutex);
+		nextTick_us.store(getMicroseconds(), std::memory_order_release);
+	}
+	// the thread may be sleeping until a tick that is now too late
+	proceedCondition.notify_one();
 }
@@ -1,16 +1,39 @@
 #ifndef logicSimulator_h
 #define logicSimulator_h
 
+#include <barrier>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <deque>
 #include <atomic>
 #include <chrono>
 #include <thread>
 
+#include "gateKernels.h"
+#include "stateVector.h"
+#include "stateSnapshot.h"
+#include "simulatorMetrics.h"
 #include "logicState.h"
 #include "gateType.h"
 #include "backend/container/block/blockDefs.h"
 
+// bit i of a lane word is gate state in the i-th independent copy of the circuit
+typedef state_word_t lane_word_t;
+constexpr unsigned int LANE_COUNT = STATE_WORD_BITS;
+
+enum class EvaluationMode {
+	SWEEP, // evaluates every gate every tick
+	EVENT_DRIVEN, // only evaluates gates whose inputs changed
+	LEVELIZED, // acyclic logic settles within one tick, gates in feedback loops keep their one tick delay
+};
+
 class LogicSimulator {
 public:
+	static constexpr unsigned int PARALLEL_MIN_GATES = 4096;
+
 	LogicSimulator();
 	~LogicSimulator();
 	void initialize();
@@ -18,38 +41,134 @@ public:
 	void connectGates(block_id_t gate1, block_id_t gate2);
 	void disconnectGates(block_id_t gate1, block_id_t gate2);
 	void decomissionGate(block_id_t gate); // TODO: figure out a better way to do this maybe
+	unsigned int getGateCount() const { return gateTypes.size(); }
+	unsigned int getDecomissionedCount() const { return freeGates.size(); }
+	// bytes allocated for the gates and connections, not counting snapshots or lanes
+	size_t getMemoryUsage() const;
 
+	// removes every decomissioned gate and groups the rest by type, touches every gate
 	std::unordered_map<block_id_t, block_id_t> compressGates();
+	// an order for reorderGates that numbers connected gates close together so propagation stays
+	// in cache. breadth first over the connections, then grouped by type like compressGates
+	std::vector<block_id_t> getLocalityOrder() const;
+	// renumbers the gates so order[i] becomes gate i, order has to list every gate that isnt decomissioned once.
+	// removes the decomissioned gates and returns the {old, new} ids of the gates that moved
+	std::vector<std::pair<block_id_t, block_id_t>> reorderGates(const std::vector<block_id_t>& order);
+	// removes every decomissioned gate by moving gates from the end into the holes.
+	// returns the {old, new} ids of the moved gates, everything else keeps its id
+	std::vector<std::pair<block_id_t, block_id_t>> fillGateHoles();
 
 	void computeNextState();
 	void propagatePowered();
 	void swapStates();
 
-	std::vector<logic_state_t> getCurrentState() const { return currentState; }
+	std::vector<logic_state_t> getCurrentState() const { return currentState.toVector(); }
 	void clearGates();
 	void reserveGates(unsigned int numGates);
 
 	void setState(block_id_t gate, logic_state_t state);
 
 	void simulateNTicks(unsigned int n);
+	// queues n ticks for the simulation thread to run as fast as it can, even while paused.
+	// the future is ready once they have all run and their states are published
+	std::future<void> queueTicks(unsigned long long n);
 
 	logic_state_t getState(block_id_t gate) const { return currentState[gate]; }
 
+	// copies the current states for readers that dont pause the thread, only call while paused
+	void publishSnapshot() { snapshot.publish(currentState); }
+	// calls func with the last published states, safe to call while the simulation is running
+	template<class Func>
+	auto readSnapshot(Func&& func) { return snapshot.read(std::forward<Func>(func)); }
+
+	// bit sliced batch simulation, runs LANE_COUNT copies of the circuit at once on the calling thread.
+	// lanes follow the same one tick per gate rules as the sweep and are separate from the normal states
+	void setLaneStates(block_id_t gate, lane_word_t states);
+	lane_word_t getLaneStates(block_id_t gate) const;
+	void resetLanes();
+	void simulateLaneTicks(unsigned int n);
+
+	// runs edit on the simulation thread at the next tick boundary, even while paused.
+	// edits are applied in the order they were queued and a snapshot is published after each batch.
+	// the future is ready once the edit ran and rethrows anything it threw
+	std::future<void> queueEdit(std::function<void()> edit);
+	// blocks until every edit queued before the call has been applied
+	void flushEdits();
+	// runs task on the simulation thread when it parks, paused or steady, after edits were applied.
+	// the task must not throw, nothing is there to catch it
+	void setIdleTask(std::function<void()> task);
+	bool hasPendingEdits() const { return editsApplied.load(std::memory_order_acquire) < editsQueued.load(std::memory_order_acquire); }
+	// waiting on an edit from inside one never returns, check this first
+	bool onSimulationThread() const { return std::this_thread::get_id() == simulationThread.get_id(); }
+
 	void debugPrint();
 	void signalToPause();
+	// signals to pause and blocks until the simulation thread is parked.
+	// queued ticks still run, use queueEdit to change a simulator that might have some
+	void waitForPause();
 	void signalToProceed();
 	bool threadIsWaiting() const;
 
 	long long int getRealTickrate() const { return realTickrate.load(std::memory_order_acquire); }
 	void setTargetTickrate(unsigned long long tickrate);
 	void triggerNextTickReset();
+	// counters from the simulation thread, all zero unless built with GATALITY_METRICS
+	SimulatorMetrics getMetrics() const;
+
+	void setEvaluationMode(EvaluationMode mode);
+	EvaluationMode getEvaluationMode() const { return evaluationMode; }
+
+	// number of threads that split up the gates of a sweep tick
+	void setWorkerCount(unsigned int count);
+	unsigned int getWorkerCount() const { return workerCount; }
 
 private:
-	std::vector<logic_state_t> currentState, nextState;
+	StateVector currentState, nextState;
 	std::vector<GateType> gateTypes;
-	std::vector<std::vector<block_id_t>> gateInputs, gateOutputs;
+	std::vector<GateTypeMasks> gateTypeMasks; // one per state word
+	// one side of a connection, twin is the index of the other side in the other gates list
+	struct GateEdge {
+		block_id_t gate;
+		unsigned int twin;
+	};
+	std::vector<std::vector<GateEdge>> gateInputs, gateOutputs; // edited, compiled into the arrays below before ticking
+	// outputs of gate i are outputTargets[outputOffsets[i]] to outputTargets[outputOffsets[i + 1]]
+	std::vector<unsigned int> outputOffsets;
+	std::vector<block_id_t> outputTargets;
+	bool connectionsCompiled = false;
 	std::vector<unsigned int> gateInputCountTotal, gateInputCountPowered;
-	int numDecomissioned;
+	std::vector<block_id_t> freeGates; // decomissioned slots that addGate can reuse
+
+	// event driven mode
+	EvaluationMode evaluationMode = EvaluationMode::SWEEP;
+	std::vector<block_id_t> dirtyGates; // gates that need to be evaluated next tick
+	std::vector<block_id_t> changedGates; // gates whose next state differs from their current state
+	std::vector<uint8_t> gateIsDirty;
+
+	// levelized mode, rebuilt with the connections
+	std::vector<block_id_t> delayedGates; // evaluated from the last tick like the sweep
+	std::vector<block_id_t> levelizedGates; // acyclic logic in topological order
+
+	// lanes, empty until first used
+	std::vector<lane_word_t> laneStates, nextLaneStates;
+	// inputs of gate i are inputSources[inputOffsets[i]] to inputSources[inputOffsets[i + 1]], only compiled while lanes are used
+	std::vector<unsigned int> inputOffsets;
+	std::vector<block_id_t> inputSources;
+
+	// published at tick boundaries and after edits
+	StateSnapshotBuffer snapshot;
+
+	// parallel sweep
+	enum class WorkerTask {
+		COMPUTE,
+		PROPAGATE,
+		STOP,
+	};
+	unsigned int workerCount = 1;
+	std::vector<std::thread> workers;
+	std::unique_ptr<std::barrier<>> workerBarrier;
+	WorkerTask workerTask = WorkerTask::STOP;
+	std::vector<unsigned int> partitionWords; // worker i runs words partitionWords[i] to partitionWords[i + 1]
 
 	// shit for threading
 	std::thread tickrateMonitorThread;
@@ -64,6 +183,71 @@ private:
 
 	std::atomic<int64_t> nextTick_us;
 
+	// the simulation thread parks on these instead of spinning
+	std::mutex pauseMutex;
+	std::condition_variable proceedCondition; // wakes the simulation thread
+	std::condition_variable waitingCondition; // wakes threads waiting for it to park
+	// lock free stack of queued edits, drained by the simulation thread
+	struct QueuedEdit {
+		std::function<void()> apply;
+		QueuedEdit* next;
+		std::promise<void> done;
+	};
+	std::atomic<QueuedEdit*> editInbox = nullptr;
+	std::atomic<unsigned long long> editsQueued = 0;
+	std::atomic<unsigned long long> editsApplied = 0;
+	void applyQueuedEdits();
+	std::function<void()> idleTask; // only touched by the simulation thread
+	bool idleTaskPending = false;
+
+	// ticks queued with queueTicks, tickRequests holds the promise for each request with the count it finishes at
+	static constexpr unsigned long long FAST_TICK_PUBLISH_INTERVAL = 1024;
+	std::atomic<unsigned long long> fastTicksRequested = 0;
+	std::atomic<unsigned long long> fastTicksRun = 0;
+	std::mutex tickRequestMutex;
+	std::deque<std::pair<unsigned long long, std::promise<void>>> tickRequests;
+	// count of fast ticks that just ran, more than one when they were skipped in a steady state
+	void finishFastTicks(unsigned long long count);
+
+	// a tick that changes nothing means every tick after it is the same until something from outside changes
+	bool isSteady() const;
+	std::atomic<bool> stateEdited = false; // set by anything that changes the gates or their states outside of a tick
+	static constexpr std::chrono::milliseconds IDLE_WAKE_INTERVAL = std::chrono::milliseconds(100);
+
+	std::mutex monitorMutex;
+	std::condition_variable monitorCondition;
+
+	SimulatorMetricCounters metrics;
+	unsigned long long countChangedGates() const; // gates the pending tick will toggle
+
+	// index of the edge in gateOutputs[gate1], or -1 if they arent connected
+	int findConnection(block_id_t gate1, block_id_t gate2) const;
+	void compileConnections();
+	void compileLevels();
+	void computeNextStateLevelized();
+	inline void propagateGate(block_id_t gate);
+	void computeNextStateWords(unsigned int firstWord, unsigned int lastWord);
+	template<bool ATOMIC>
+	void propagatePoweredWords(unsigned int firstWord, unsigned int lastWord);
+
+	// small circuits are faster on one thread
+	inline bool usingWorkers() const { return workerCount > 1 && currentState.size() >= PARALLEL_MIN_GATES; }
+	void partitionWorkers();
+	void runOnWorkers(WorkerTask task);
+	void runWorkerTask(unsigned int worker);
+	void workerLoop(unsigned int worker);
+	void stopWorkers();
+	inline logic_state_t computeGateState(block_id_t gate) const;
+	inline void setGateTypeMasks(block_id_t gate, GateType type);
+	static constexpr block_id_t INVALID_GATE = ~(block_id_t)0;
+	// live gates stably sorted by type
+	std::vector<block_id_t> groupByType(const std::vector<block_id_t>& gates) const;
+	// moves order[i] to gate i and drops the rest, returns the new id of every old gate or INVALID_GATE
+	std::vector<block_id_t> permuteGates(const std::vector<block_id_t>& order);
+	void moveGate(block_id_t from, block_id_t to); // to must be decomissioned
+	inline void markDirty(block_id_t gate);
+	void markAllDirty();
+
 	void simulationLoop();
 	void tickrateMonitor();
 };
@@ -0,0 +1,26 @@
+#include "simulatorMetrics.h"
+
+std::string SimulatorMetrics::toJson() const {
+	std::stringstream stream;
+	stream << "{";
+	stream << "\"enabled\":" << (METRICS_ENABLED ? "true" : "false");
+	stream << ",\"ticks\":" << ticks;
+	stream << ",\"gatesToggled\":" << gatesToggled;
+	stream << ",\"lastTickGatesToggled\":" << lastTickGatesToggled;
+	stream << ",\"computeTime_ns\":" << computeTime_ns;
+	stream << ",\"propagateTime_ns\":" << propagateTime_ns;
+	stream << ",\"pauseWaitTime_ns\":" << pauseWaitTime_ns;
+	stream << ",\"editQueueDepth\":" << editQueueDepth;
+	stream << ",\"maxEditBatch\":" << maxEditBatch;
+	stream << ",\"readWaits\":" << readWaits;
+	stream << ",\"readWaitTime_ns\":" << readWaitTime_ns;
+	stream << ",\"maxReadWait_ns\":" << maxReadWait_ns;
+	// bucket i holds ticks under 2^i ns
+	stream << ",\"tickDurationHistogram\":[";
+	for (unsigned int i = 0; i < TICK_HISTOGRAM_BUCKETS; ++i) {
+		if (i) stream << ",";
+		stream << tickDurationHistogram[i];
+	}
+	stream << "]}";
+	return stream.str();
+}
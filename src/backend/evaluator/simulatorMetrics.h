@@ -0,0 +1,106 @@
+#ifndef simulatorMetrics_h
+#define simulatorMetrics_h
+
+#include <atomic>
+#include <array>
+#include <bit>
+
+// counters cost a few clock reads per tick, builds for maximum throughput can leave them out
+#ifdef GATALITY_METRICS
+constexpr bool METRICS_ENABLED = true;
+#else
+constexpr bool METRICS_ENABLED = false;
+#endif
+
+// bucket i counts ticks that took under 2^i ns, the last one also counts everything slower
+constexpr unsigned int TICK_HISTOGRAM_BUCKETS = 32;
+
+struct SimulatorMetrics {
+	unsigned long long ticks = 0; // ticks computed by the simulation thread, skipped steady ticks are not counted
+	unsigned long long gatesToggled = 0;
+	unsigned long long lastTickGatesToggled = 0;
+	unsigned long long computeTime_ns = 0;
+	unsigned long long propagateTime_ns = 0;
+	unsigned long long pauseWaitTime_ns = 0; // parked between ticks, paused or waiting for the tickrate
+	unsigned long long editQueueDepth = 0; // edits queued but not applied yet
+	unsigned long long maxEditBatch = 0; // most edits applied at one tick boundary
+	// time reads spent waiting for queued edits before they could read the states
+	unsigned long long readWaits = 0;
+	unsigned long long readWaitTime_ns = 0;
+	unsigned long long maxReadWait_ns = 0;
+	std::array<unsigned long long, TICK_HISTOGRAM_BUCKETS> tickDurationHistogram = {};
+
+	std::string toJson() const;
+};
+
+// Written by the simulation thread and read from anywhere. Counters are relaxed so a read can mix
+// values from neighbouring ticks. Every record is a no op without GATALITY_METRICS.
+class SimulatorMetricCounters {
+public:
+	void recordTick(unsigned long long compute_ns, unsigned long long propagate_ns, unsigned long long tick_ns, unsigned long long toggled) {
+		if constexpr (METRICS_ENABLED) {
+			add(ticks, 1);
+			add(gatesToggled, toggled);
+			lastTickGatesToggled.store(toggled, std::memory_order_relaxed);
+			add(computeTime_ns, compute_ns);
+			add(propagateTime_ns, propagate_ns);
+			add(tickDurationHistogram[std::min<unsigned int>(std::bit_width(tick_ns), TICK_HISTOGRAM_BUCKETS - 1)], 1);
+		}
+	}
+	void recordPauseWait(unsigned long long wait_ns) {
+		if constexpr (METRICS_ENABLED) add(pauseWaitTime_ns, wait_ns);
+	}
+	void recordEditBatch(unsigned long long edits) {
+		if constexpr (METRICS_ENABLED) raise(maxEditBatch, edits);
+	}
+	// called by the reading threads
+	void recordReadWait(unsigned long long wait_ns) {
+		if constexpr (METRICS_ENABLED) {
+			readWaits.fetch_add(1, std::memory_order_relaxed);
+			readWaitTime_ns.fetch_add(wait_ns, std::memory_order_relaxed);
+			unsigned long long max = maxReadWait_ns.load(std::memory_order_relaxed);
+			while (wait_ns > max && !maxReadWait_ns.compare_exchange_weak(max, wait_ns, std::memory_order_relaxed));
+		}
+	}
+
+	SimulatorMetrics read() const {
+		SimulatorMetrics metrics;
+		metrics.ticks = ticks.load(std::memory_order_relaxed);
+		metrics.gatesToggled = gatesToggled.load(std::memory_order_relaxed);
+		metrics.lastTickGatesToggled = lastTickGatesToggled.load(std::memory_order_relaxed);
+		metrics.computeTime_ns = computeTime_ns.load(std::memory_order_relaxed);
+		metrics.propagateTime_ns = propagateTime_ns.load(std::memory_order_relaxed);
+		metrics.pauseWaitTime_ns = pauseWaitTime_ns.load(std::memory_order_relaxed);
+		metrics.maxEditBatch = maxEditBatch.load(std::memory_order_relaxed);
+		metrics.readWaits = readWaits.load(std::memory_order_relaxed);
+		metrics.readWaitTime_ns = readWaitTime_ns.load(std::memory_order_relaxed);
+		metrics.maxReadWait_ns = maxReadWait_ns.load(std::memory_order_relaxed);
+		for (unsigned int i = 0; i < TICK_HISTOGRAM_BUCKETS; ++i) {
+			metrics.tickDurationHistogram[i] = tickDurationHistogram[i].load(std::memory_order_relaxed);
+		}
+		return metrics;
+	}
+
+private:
+	// only the simulation thread writes these so they dont need a read modify write
+	static void add(std::atomic<unsigned long long>& counter, unsigned long long amount) {
+		counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+	}
+	static void raise(std::atomic<unsigned long long>& counter, unsigned long long value) {
+		if (value > counter.load(std::memory_order_relaxed)) counter.store(value, std::memory_order_relaxed);
+	}
+
+	std::atomic<unsigned long long> ticks = 0;
+	std::atomic<unsigned long long> gatesToggled = 0;
+	std::atomic<unsigned long long> lastTickGatesToggled = 0;
+	std::atomic<unsigned long long> computeTime_ns = 0;
+	std::atomic<unsigned long long> propagateTime_ns = 0;
+	std::atomic<unsigned long long> pauseWaitTime_ns = 0;
+	std::atomic<unsigned long long> maxEditBatch = 0;
+	std::atomic<unsigned long long> readWaits = 0;
+	std::atomic<unsigned long long> readWaitTime_ns = 0;
+	std::atomic<unsigned long long> maxReadWait_ns = 0;
+	std::array<std::atomic<unsigned long long>, TICK_HISTOGRAM_BUCKETS> tickDurationHistogram = {};
+};
+
+#endif /* simulatorMetrics_h */
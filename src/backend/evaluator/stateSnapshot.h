@@ -0,0 +1,41 @@
+#ifndef stateSnapshot_h
+#define stateSnapshot_h
+
+#include <atomic>
+#include <mutex>
+
+#include "stateVector.h"
+
+// Triple buffer of StateVectors. One writer publishes copies of its states and readers take the
+// most recently published one without ever blocking the writer.
+class StateSnapshotBuffer {
+public:
+	// Only one thread may publish at a time.
+	void publish(const StateVector& states) {
+		buffers[backIndex] = states;
+		// hand the filled buffer to the readers and take back whatever they left in the middle
+		backIndex = middle.exchange(backIndex | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+	}
+
+	// Calls func with the newest published states. Readers are serialized against each other but not the writer.
+	template<class Func>
+	auto read(Func&& func) {
+		std::lock_guard<std::mutex> lock(readerMutex);
+		if (middle.load(std::memory_order_relaxed) & FRESH_BIT) {
+			frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX_MASK;
+		}
+		return func(const_cast<const StateVector&>(buffers[frontIndex]));
+	}
+
+private:
+	static constexpr unsigned int INDEX_MASK = 3;
+	static constexpr unsigned int FRESH_BIT = 4;
+
+	StateVector buffers[3];
+	unsigned int backIndex = 0; // owned by the writer
+	std::atomic<unsigned int> middle = 1;
+	unsigned int frontIndex = 2; // owned by the readers
+	std::mutex readerMutex;
+};
+
+#endif /* stateSnapshot_h */
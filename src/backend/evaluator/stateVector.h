@@ -0,0 +1,59 @@
+#ifndef stateVector_h
+#define stateVector_h
+
+#include "logicState.h"
+#include "backend/container/block/blockDefs.h"
+
+typedef std::uint64_t state_word_t;
+constexpr unsigned int STATE_WORD_BITS = 64;
+
+// Stores one logic_state_t per bit so a word holds the states of 64 consecutive gates.
+// Only works while logic_state_t is a bool.
+class StateVector {
+public:
+	inline logic_state_t get(block_id_t index) const { return (words[index / STATE_WORD_BITS] >> (index % STATE_WORD_BITS)) & 1; }
+	inline logic_state_t operator[](block_id_t index) const { return get(index); }
+	inline void set(block_id_t index, logic_state_t state) {
+		const state_word_t bit = (state_word_t)1 << (index % STATE_WORD_BITS);
+		if (state) words[index / STATE_WORD_BITS] |= bit;
+		else words[index / STATE_WORD_BITS] &= ~bit;
+	}
+
+	inline unsigned int size() const { return count; }
+	inline unsigned int wordCount() const { return words.size(); }
+	inline state_word_t getWord(unsigned int wordIndex) const { return words[wordIndex]; }
+	inline void setWord(unsigned int wordIndex, state_word_t word) { words[wordIndex] = word; }
+	inline const state_word_t* data() const { return words.data(); }
+	inline size_t memoryUsage() const { return words.capacity() * sizeof(state_word_t); }
+
+	inline void push_back(logic_state_t state) {
+		if (count % STATE_WORD_BITS == 0) words.push_back(0);
+		set(count++, state);
+	}
+	inline void resize(unsigned int size) {
+		words.resize((size + STATE_WORD_BITS - 1) / STATE_WORD_BITS, 0);
+		count = size;
+		// keep the unused bits of the last word cleared
+		if (count % STATE_WORD_BITS) words.back() &= ((state_word_t)1 << (count % STATE_WORD_BITS)) - 1;
+	}
+	inline void reserve(unsigned int size) { words.reserve((size + STATE_WORD_BITS - 1) / STATE_WORD_BITS); }
+	inline void clear() { words.clear(); count = 0; }
+	inline void reset() { std::fill(words.begin(), words.end(), 0); }
+
+	inline bool operator==(const StateVector& other) const { return count == other.count && words == other.words; }
+
+	std::vector<logic_state_t> toVector() const {
+		std::vector<logic_state_t> states;
+		states.reserve(count);
+		for (block_id_t i = 0; i < count; ++i) {
+			states.push_back(get(i));
+		}
+		return states;
+	}
+
+private:
+	std::vector<state_word_t> words;
+	unsigned int count = 0;
+};
+
+#endif /* stateVector_h */
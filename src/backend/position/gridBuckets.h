@@ -0,0 +1,130 @@
+#ifndef gridBuckets_h
+#define gridBuckets_h
+
+#include <array>
+
+#include "position.h"
+#include "positionMap.h"
+
+// Spatial index of values that each cover a rectangle. The buckets come in levels, each LEVEL_BITS times
+// coarser than the one before. A value is kept in the bucket holding the small corner of its rectangle on
+// the first level whose buckets are bigger than it, so long values dont end up in a list every query has
+// to check. Queries only look at the buckets around the area on each level so their cost follows what is
+// near the area instead of how much is stored.
+template <class T>
+class GridBuckets {
+public:
+	static constexpr unsigned int BUCKET_BITS = 5; // of the finest level
+	static constexpr unsigned int LEVEL_BITS = 3;
+	// the last level has buckets as big as the whole coordinate range
+	static constexpr unsigned int LEVEL_COUNT = (sizeof(cord_t) * 8 - BUCKET_BITS + LEVEL_BITS - 1) / LEVEL_BITS + 1;
+
+	inline unsigned int size() const { return count; }
+
+	// small and large are the inclusive corners of the area the value covers
+	void insert(const Position& small, const Position& large, const T& value);
+	// the area has to be the same one it was inserted with. returns false if it wasnt found
+	bool remove(const Position& small, const Position& large, const T& value);
+	void clear() { for (Level& level : levels) { level.buckets.clear(); level.count = 0; } count = 0; }
+
+	// calls func(value) for every value whose area overlaps small to large (inclusive)
+	template<class Func>
+	void forEachInArea(const Position& small, const Position& large, Func&& func) const;
+
+private:
+	struct Item {
+		Position small, large;
+		T value;
+	};
+
+	struct Level {
+		FlatPositionMap<std::vector<Item>> buckets;
+		unsigned int count = 0;
+	};
+
+	static inline unsigned int bucketBits(unsigned int level) { return BUCKET_BITS + level * LEVEL_BITS; }
+	// 64 bit so corners a bucket past the coordinate range and the widest spans dont overflow
+	static inline Position bucketOf(int64_t x, int64_t y, unsigned int level) {
+		return Position((cord_t)(x >> bucketBits(level)), (cord_t)(y >> bucketBits(level)));
+	}
+	// values smaller than a bucket can be found by looking one bucket further up and left of the area
+	static inline unsigned int levelOf(const Position& small, const Position& large) {
+		const int64_t span = std::max((int64_t)large.x - small.x, (int64_t)large.y - small.y);
+		unsigned int level = 0;
+		while (level + 1 < LEVEL_COUNT && span >= ((int64_t)1 << bucketBits(level))) ++level;
+		return level;
+	}
+	static inline bool overlaps(const Item& item, const Position& small, const Position& large) {
+		return item.small.x <= large.x && small.x <= item.large.x && item.small.y <= large.y && small.y <= item.large.y;
+	}
+	static bool removeItem(std::vector<Item>& items, const Position& small, const Position& large, const T& value);
+
+	std::array<Level, LEVEL_COUNT> levels;
+	unsigned int count = 0;
+};
+
+template<class T>
+void GridBuckets<T>::insert(const Position& small, const Position& large, const T& value) {
+	++count;
+	const unsigned int levelIndex = levelOf(small, large);
+	Level& level = levels[levelIndex];
+	++level.count;
+	const Position bucket = bucketOf(small.x, small.y, levelIndex);
+	std::vector<Item>* items = level.buckets.get(bucket);
+	if (!items) {
+		level.buckets.insert(bucket, std::vector<Item>());
+		items = level.buckets.get(bucket);
+	}
+	items->push_back({ small, large, value });
+}
+
+template<class T>
+bool GridBuckets<T>::remove(const Position& small, const Position& large, const T& value) {
+	const unsigned int levelIndex = levelOf(small, large);
+	Level& level = levels[levelIndex];
+	const Position bucket = bucketOf(small.x, small.y, levelIndex);
+	std::vector<Item>* items = level.buckets.get(bucket);
+	if (!items || !removeItem(*items, small, large, value)) return false;
+	if (items->empty()) level.buckets.remove(bucket);
+	--level.count;
+	--count;
+	return true;
+}
+
+template<class T>
+bool GridBuckets<T>::removeItem(std::vector<Item>& items, const Position& small, const Position& large, const T& value) {
+	// from the back since undo removes the newest values first
+	for (unsigned int i = items.size(); i > 0; --i) {
+		if (items[i - 1].value == value && items[i - 1].small == small && items[i - 1].large == large) {
+			items[i - 1] = std::move(items.back());
+			items.pop_back();
+			return true;
+		}
+	}
+	return false;
+}
+
+template<class T>
+template<class Func>
+void GridBuckets<T>::forEachInArea(const Position& small, const Position& large, Func&& func) const {
+	if (small.x > large.x || small.y > large.y) return;
+	for (unsigned int levelIndex = 0; levelIndex < LEVEL_COUNT; ++levelIndex) {
+		const Level& level = levels[levelIndex];
+		if (level.count == 0) continue;
+		// a value that reaches into the area starts at most one bucket before it
+		const int64_t reach = ((int64_t)1 << bucketBits(levelIndex)) - 1;
+		const Position firstBucket = bucketOf(small.x - reach, small.y - reach, levelIndex);
+		const Position lastBucket = bucketOf(large.x, large.y, levelIndex);
+		for (cord_t bucketX = firstBucket.x; bucketX <= lastBucket.x; ++bucketX) {
+			for (cord_t bucketY = firstBucket.y; bucketY <= lastBucket.y; ++bucketY) {
+				const std::vector<Item>* items = level.buckets.get(Position(bucketX, bucketY));
+				if (!items) continue;
+				for (const Item& item : *items) {
+					if (overlaps(item, small, large)) func(item.value);
+				}
+			}
+		}
+	}
+}
+
+#endif /* gridBuckets_h */
@@ -0,0 +1,145 @@
+#ifndef positionMap_h
+#define positionMap_h
+
+#include <bit>
+
+#include "position.h"
+
+// Hash map from Position to T. Entries are kept packed in one array in the order they were added and
+// an open addressing table of 32 bit entry indices finds them. Lookups dont allocate or chase
+// pointers, the index table is small enough to stay in cache and looking up entries in the order
+// they were added reads the entries front to back.
+template <class T>
+class FlatPositionMap {
+public:
+	inline T* get(const Position& position);
+	inline const T* get(const Position& position) const;
+	// checks the entry at hint before the index table and leaves hint after the entry found. passing the
+	// same hint to a run of lookups made in the order the entries were added never touches the table
+	inline const T* get(const Position& position, unsigned int& hint) const;
+	inline bool contains(const Position& position) const { return get(position) != nullptr; }
+	inline unsigned int size() const { return entries.size(); }
+
+	// returns false and leaves the old value if position already has one
+	bool insert(const Position& position, const T& value);
+	// returns false if position had no value. the last entry takes the place of the removed one
+	bool remove(const Position& position);
+	void clear() { entries.clear(); table.clear(); shift = 64; }
+
+	// calls func(position, value) for every entry, the values can be changed but not the positions
+	template<class Func>
+	void forEach(Func&& func);
+
+private:
+	struct Entry {
+		uint64_t key;
+		T value;
+	};
+	static constexpr uint32_t EMPTY_SLOT = ~(uint32_t)0;
+
+	static inline uint64_t packPosition(const Position& position) { return ((uint64_t)(uint32_t)position.x << 32) | (uint32_t)position.y; }
+	static inline Position unpackPosition(uint64_t key) { return Position((cord_t)(uint32_t)(key >> 32), (cord_t)(uint32_t)key); }
+	// fibonacci hashing, the top bits of the product pick the slot
+	inline size_t homeSlot(uint64_t key) const { return (key * 0x9E3779B97F4A7C15ull) >> shift; }
+	inline size_t nextSlot(size_t slot) const { return (slot + 1) & (table.size() - 1); }
+	// the slot holding the entry with key, or the empty slot it would go in
+	inline size_t findSlot(uint64_t key) const;
+	void grow();
+
+	std::vector<Entry> entries;
+	// index into entries or EMPTY_SLOT, size is 0 or a power of two. not named slots, Qt defines that as a macro
+	std::vector<uint32_t> table;
+	unsigned int shift = 64; // 64 - log2(table.size())
+};
+
+template<class T>
+size_t FlatPositionMap<T>::findSlot(uint64_t key) const {
+	size_t slot = homeSlot(key);
+	while (table[slot] != EMPTY_SLOT && entries[table[slot]].key != key) {
+		slot = nextSlot(slot);
+	}
+	return slot;
+}
+
+template<class T>
+T* FlatPositionMap<T>::get(const Position& position) {
+	if (entries.empty()) return nullptr;
+	const uint32_t index = table[findSlot(packPosition(position))];
+	return index == EMPTY_SLOT ? nullptr : &entries[index].value;
+}
+
+template<class T>
+const T* FlatPositionMap<T>::get(const Position& position) const {
+	if (entries.empty()) return nullptr;
+	const uint32_t index = table[findSlot(packPosition(position))];
+	return index == EMPTY_SLOT ? nullptr : &entries[index].value;
+}
+
+template<class T>
+const T* FlatPositionMap<T>::get(const Position& position, unsigned int& hint) const {
+	const uint64_t key = packPosition(position);
+	if (hint < entries.size() && entries[hint].key == key) return &entries[hint++].value;
+	if (entries.empty()) return nullptr;
+	const uint32_t index = table[findSlot(key)];
+	if (index == EMPTY_SLOT) return nullptr;
+	hint = index + 1;
+	return &entries[index].value;
+}
+
+template<class T>
+bool FlatPositionMap<T>::insert(const Position& position, const T& value) {
+	// keep the load under 50% so probes stay short, the table are only 4 bytes
+	if ((entries.size() + 1) * 2 > table.size()) grow();
+	const uint64_t key = packPosition(position);
+	const size_t slot = findSlot(key);
+	if (table[slot] != EMPTY_SLOT) return false;
+	table[slot] = entries.size();
+	entries.push_back({ key, value });
+	return true;
+}
+
+template<class T>
+bool FlatPositionMap<T>::remove(const Position& position) {
+	if (entries.empty()) return false;
+	size_t hole = findSlot(packPosition(position));
+	const uint32_t index = table[hole];
+	if (index == EMPTY_SLOT) return false;
+
+	// pull back every slot after the hole that would not be found past it anymore
+	for (size_t slot = nextSlot(hole); table[slot] != EMPTY_SLOT; slot = nextSlot(slot)) {
+		const size_t home = homeSlot(entries[table[slot]].key);
+		// the slot can move if its home is not cyclically within (hole, slot]
+		const bool homeAfterHole = hole <= slot ? (hole < home && home <= slot) : (hole < home || home <= slot);
+		if (homeAfterHole) continue;
+		table[hole] = table[slot];
+		hole = slot;
+	}
+	table[hole] = EMPTY_SLOT;
+
+	// swap remove the entry and point the slot of the moved one at its new index
+	if (index != entries.size() - 1) {
+		table[findSlot(entries.back().key)] = index;
+		entries[index] = std::move(entries.back());
+	}
+	entries.pop_back();
+	return true;
+}
+
+template<class T>
+template<class Func>
+void FlatPositionMap<T>::forEach(Func&& func) {
+	for (Entry& entry : entries) {
+		func(unpackPosition(entry.key), entry.value);
+	}
+}
+
+template<class T>
+void FlatPositionMap<T>::grow() {
+	table.assign(table.empty() ? 16 : table.size() * 2, EMPTY_SLOT);
+	shift = 64 - std::countr_zero(table.size());
+	for (uint32_t index = 0; index < entries.size(); ++index) {
+		table[findSlot(entries[index].key)] = index;
+	}
+}
+
+#endif /* positionMap_h */
@@ -2,6 +2,7 @@
 #define sparse2d_h
 
 #include "position.h"
+#include "positionMap.h"
 
 /*
 Should be defined as:
@@ -15,13 +16,17 @@ public:
 	const T* get(const Position& position) const;
 	void insert(const Position& position, const T& value);
 	void remove(const Position& position)
+	bool anyInArea(const Position& small, const Position& large) const;
+	void insertArea(const Position& small, const Position& large, const T& value);
+	void removeArea(const Position& small, const Position& large);
 }
 */
 
 template <class T> class Sparse2dArray;
+template <class T> class Sparse2dChunked;
 
 template <class T>
-using Sparse2d = Sparse2dArray<T>;
+using Sparse2d = Sparse2dChunked<T>;
 
 
 template <class T>
@@ -34,6 +39,10 @@ public:
 	inline void insert(const Position& position, const T& value);
 	inline void remove(const Position& position);
 
+	bool anyInArea(const Position& small, const Position& large) const;
+	void insertArea(const Position& small, const Position& large, const T& value);
+	void removeArea(const Position& small, const Position& large);
+
 private:
 	std::unordered_map<Position, T> data;
 
@@ -78,4 +87,278 @@ void Sparse2dArray<T>::remove(const Position& position) {
 		data.erase(iter);
 }
 
+template<class T>
+bool Sparse2dArray<T>::anyInArea(const Position& small, const Position& large) const {
+	for (cord_t x = small.x; x <= large.x; x++) {
+		for (cord_t y = small.y; y <= large.y; y++) {
+			if (get(Position(x, y))) return true;
+		}
+	}
+	return false;
+}
+
+template<class T>
+void Sparse2dArray<T>::insertArea(const Position& small, const Position& large, const T& value) {
+	for (cord_t x = small.x; x <= large.x; x++) {
+		for (cord_t y = small.y; y <= large.y; y++) {
+			insert(Position(x, y), value);
+		}
+	}
+}
+
+template<class T>
+void Sparse2dArray<T>::removeArea(const Position& small, const Position& large) {
+	for (cord_t x = small.x; x <= large.x; x++) {
+		for (cord_t y = small.y; y <= large.y; y++) {
+			remove(Position(x, y));
+		}
+	}
+}
+
+// Cells are stored in dense CHUNK_SIZE x CHUNK_SIZE chunks found by their chunk coordinates. Each chunk
+// has one bit per cell saying if it has a value so area checks and area edits work a row of a chunk at a time.
+// Chunks are freed once they are empty. Pointers stay valid until their cell or chunk is removed.
+template <class T>
+class Sparse2dChunked {
+public:
+	static constexpr unsigned int CHUNK_BITS = 5;
+	static constexpr unsigned int CHUNK_SIZE = 1 << CHUNK_BITS;
+
+	Sparse2dChunked() = default;
+	Sparse2dChunked(const Sparse2dChunked<T>& other) { *this = other; }
+	Sparse2dChunked<T>& operator=(const Sparse2dChunked<T>& other);
+	Sparse2dChunked(Sparse2dChunked<T>&& other) = default;
+	Sparse2dChunked<T>& operator=(Sparse2dChunked<T>&& other) = default;
+
+	inline T* get(const Position& position);
+	inline const T* get(const Position& position) const;
+	inline unsigned int size() const { return cellCount; }
+
+	void insert(const Position& position, const T& value);
+	void remove(const Position& position);
+
+	// if any cell from small to large (inclusive) has a value
+	bool anyInArea(const Position& small, const Position& large) const;
+	void insertArea(const Position& small, const Position& large, const T& value);
+	void removeArea(const Position& small, const Position& large);
+
+private:
+	typedef uint32_t row_mask_t;
+	static_assert(sizeof(row_mask_t) * 8 == CHUNK_SIZE);
+	static constexpr cord_t CHUNK_MASK = CHUNK_SIZE - 1;
+
+	class Chunk {
+	public:
+		Chunk(const Position& chunkPosition) : chunkPosition(chunkPosition) { }
+		Chunk(const Chunk& other);
+		Chunk& operator=(const Chunk& other) = delete;
+		~Chunk();
+
+		inline bool has(unsigned int x, unsigned int y) const { return (rows[y] >> x) & 1; }
+		inline T* cell(unsigned int x, unsigned int y) { return std::launder(reinterpret_cast<T*>(storage) + y * CHUNK_SIZE + x); }
+		inline const T* cell(unsigned int x, unsigned int y) const { return std::launder(reinterpret_cast<const T*>(storage) + y * CHUNK_SIZE + x); }
+		// returns the number of cells that got a value
+		unsigned int insertRow(unsigned int y, row_mask_t mask, const T& value);
+		// returns the number of cells that lost their value
+		unsigned int removeRow(unsigned int y, row_mask_t mask);
+
+		Position chunkPosition;
+		unsigned int count = 0;
+		std::array<row_mask_t, CHUNK_SIZE> rows = {}; // bit x of rows[y] is set if that cell has a value
+
+	private:
+		alignas(T) unsigned char storage[CHUNK_SIZE * CHUNK_SIZE * sizeof(T)];
+	};
+
+	static inline Position chunkOf(const Position& position) { return Position(position.x >> CHUNK_BITS, position.y >> CHUNK_BITS); }
+	// bits first to last of a row
+	static inline row_mask_t rowMask(unsigned int first, unsigned int last) {
+		return (last == CHUNK_SIZE - 1 ? ~(row_mask_t)0 : ((row_mask_t)1 << (last + 1)) - 1) & ~(((row_mask_t)1 << first) - 1);
+	}
+	inline Chunk* getChunk(const Position& chunkPosition) const {
+		const unsigned int* index = chunkIndices.get(chunkPosition);
+		return index ? chunks[*index].get() : nullptr;
+	}
+	Chunk& getOrMakeChunk(const Position& chunkPosition);
+	void freeChunk(const Position& chunkPosition);
+	// calls func(chunkPosition, firstX, lastX, firstY, lastY) with the local bounds of each chunk the area covers
+	template<class Func>
+	static void forEachChunkInArea(const Position& small, const Position& large, Func&& func);
+
+	FlatPositionMap<unsigned int> chunkIndices; // index into chunks
+	std::vector<std::unique_ptr<Chunk>> chunks;
+	unsigned int cellCount = 0;
+};
+
+template<class T>
+Sparse2dChunked<T>::Chunk::Chunk(const Chunk& other) : chunkPosition(other.chunkPosition), count(other.count), rows(other.rows) {
+	for (unsigned int y = 0; y < CHUNK_SIZE; ++y) {
+		for (row_mask_t bits = rows[y]; bits; bits &= bits - 1) {
+			const unsigned int x = std::countr_zero(bits);
+			new (cell(x, y)) T(*other.cell(x, y));
+		}
+	}
+}
+
+template<class T>
+Sparse2dChunked<T>::Chunk::~Chunk() {
+	for (unsigned int y = 0; y < CHUNK_SIZE; ++y) {
+		for (row_mask_t bits = rows[y]; bits; bits &= bits - 1) {
+			cell(std::countr_zero(bits), y)->~T();
+		}
+	}
+}
+
+template<class T>
+unsigned int Sparse2dChunked<T>::Chunk::insertRow(unsigned int y, row_mask_t mask, const T& value) {
+	for (row_mask_t bits = mask & rows[y]; bits; bits &= bits - 1) {
+		*cell(std::countr_zero(bits), y) = value;
+	}
+	const row_mask_t added = mask & ~rows[y];
+	for (row_mask_t bits = added; bits; bits &= bits - 1) {
+		new (cell(std::countr_zero(bits), y)) T(value);
+	}
+	rows[y] |= added;
+	const unsigned int addedCount = std::popcount(added);
+	count += addedCount;
+	return addedCount;
+}
+
+template<class T>
+unsigned int Sparse2dChunked<T>::Chunk::removeRow(unsigned int y, row_mask_t mask) {
+	const row_mask_t removed = mask & rows[y];
+	for (row_mask_t bits = removed; bits; bits &= bits - 1) {
+		cell(std::countr_zero(bits), y)->~T();
+	}
+	rows[y] &= ~removed;
+	const unsigned int removedCount = std::popcount(removed);
+	count -= removedCount;
+	return removedCount;
+}
+
+template<class T>
+Sparse2dChunked<T>& Sparse2dChunked<T>::operator=(const Sparse2dChunked<T>& other) {
+	if (this == &other) return *this;
+	chunkIndices = other.chunkIndices;
+	chunks.clear();
+	chunks.reserve(other.chunks.size());
+	for (const auto& chunk : other.chunks) {
+		chunks.push_back(std::make_unique<Chunk>(*chunk));
+	}
+	cellCount = other.cellCount;
+	return *this;
+}
+
+template<class T>
+T* Sparse2dChunked<T>::get(const Position& position) {
+	Chunk* chunk = getChunk(chunkOf(position));
+	const unsigned int x = position.x & CHUNK_MASK, y = position.y & CHUNK_MASK;
+	return chunk && chunk->has(x, y) ? chunk->cell(x, y) : nullptr;
+}
+
+template<class T>
+const T* Sparse2dChunked<T>::get(const Position& position) const {
+	const Chunk* chunk = getChunk(chunkOf(position));
+	const unsigned int x = position.x & CHUNK_MASK, y = position.y & CHUNK_MASK;
+	return chunk && chunk->has(x, y) ? chunk->cell(x, y) : nullptr;
+}
+
+template<class T>
+void Sparse2dChunked<T>::insert(const Position& position, const T& value) {
+	const unsigned int x = position.x & CHUNK_MASK, y = position.y & CHUNK_MASK;
+	cellCount += getOrMakeChunk(chunkOf(position)).insertRow(y, (row_mask_t)1 << x, value);
+}
+
+template<class T>
+void Sparse2dChunked<T>::remove(const Position& position) {
+	const Position chunkPosition = chunkOf(position);
+	Chunk* chunk = getChunk(chunkPosition);
+	if (!chunk) return;
+	const unsigned int x = position.x & CHUNK_MASK, y = position.y & CHUNK_MASK;
+	cellCount -= chunk->removeRow(y, (row_mask_t)1 << x);
+	if (chunk->count == 0) freeChunk(chunkPosition);
+}
+
+template<class T>
+template<class Func>
+void Sparse2dChunked<T>::forEachChunkInArea(const Position& small, const Position& large, Func&& func) {
+	const Position firstChunk = chunkOf(small), lastChunk = chunkOf(large);
+	for (cord_t chunkY = firstChunk.y; chunkY <= lastChunk.y; ++chunkY) {
+		const unsigned int firstY = chunkY == firstChunk.y ? small.y & CHUNK_MASK : 0;
+		const unsigned int lastY = chunkY == lastChunk.y ? large.y & CHUNK_MASK : CHUNK_SIZE - 1;
+		for (cord_t chunkX = firstChunk.x; chunkX <= lastChunk.x; ++chunkX) {
+			const unsigned int firstX = chunkX == firstChunk.x ? small.x & CHUNK_MASK : 0;
+			const unsigned int lastX = chunkX == lastChunk.x ? large.x & CHUNK_MASK : CHUNK_SIZE - 1;
+			if (!func(Position(chunkX, chunkY), firstX, lastX, firstY, lastY)) return;
+		}
+	}
+}
+
+template<class T>
+bool Sparse2dChunked<T>::anyInArea(const Position& small, const Position& large) const {
+	if (small.x > large.x || small.y > large.y) return false;
+	bool found = false;
+	forEachChunkInArea(small, large, [&](const Position& chunkPosition, unsigned int firstX, unsigned int lastX, unsigned int firstY, unsigned int lastY) {
+		const Chunk* chunk = getChunk(chunkPosition);
+		if (!chunk) return true;
+		const row_mask_t mask = rowMask(firstX, lastX);
+		for (unsigned int y = firstY; y <= lastY; ++y) {
+			if (chunk->rows[y] & mask) {
+				found = true;
+				return false;
+			}
+		}
+		return true;
+	});
+	return found;
+}
+
+template<class T>
+void Sparse2dChunked<T>::insertArea(const Position& small, const Position& large, const T& value) {
+	if (small.x > large.x || small.y > large.y) return;
+	forEachChunkInArea(small, large, [&](const Position& chunkPosition, unsigned int firstX, unsigned int lastX, unsigned int firstY, unsigned int lastY) {
+		Chunk& chunk = getOrMakeChunk(chunkPosition);
+		const row_mask_t mask = rowMask(firstX, lastX);
+		for (unsigned int y = firstY; y <= lastY; ++y) {
+			cellCount += chunk.insertRow(y, mask, value);
+		}
+		return true;
+	});
+}
+
+template<class T>
+void Sparse2dChunked<T>::removeArea(const Position& small, const Position& large) {
+	if (small.x > large.x || small.y > large.y) return;
+	forEachChunkInArea(small, large, [&](const Position& chunkPosition, unsigned int firstX, unsigned int lastX, unsigned int firstY, unsigned int lastY) {
+		Chunk* chunk = getChunk(chunkPosition);
+		if (!chunk) return true;
+		const row_mask_t mask = rowMask(firstX, lastX);
+		for (unsigned int y = firstY; y <= lastY; ++y) {
+			cellCount -= chunk->removeRow(y, mask);
+		}
+		if (chunk->count == 0) freeChunk(chunkPosition);
+		return true;
+	});
+}
+
+template<class T>
+typename Sparse2dChunked<T>::Chunk& Sparse2dChunked<T>::getOrMakeChunk(const Position& chunkPosition) {
+	if (Chunk* chunk = getChunk(chunkPosition)) return *chunk;
+	chunkIndices.insert(chunkPosition, chunks.size());
+	chunks.push_back(std::make_unique<Chunk>(chunkPosition));
+	return *chunks.back();
+}
+
+template<class T>
+void Sparse2dChunked<T>::freeChunk(const Position& chunkPosition) {
+	const unsigned int index = *chunkIndices.get(chunkPosition);
+	chunkIndices.remove(chunkPosition);
+	// swap remove and point the index of the moved chunk at its new place
+	if (index != chunks.size() - 1) {
+		chunks[index] = std::move(chunks.back());
+		*chunkIndices.get(chunks[index]->chunkPosition) = index;
+	}
+	chunks.pop_back();
+}
+
 #endif /* sparse2d_h */
@@ -80,13 +80,52 @@ void QtRenderer::render(QPainter* painter) {
 	Position topLeftBound = viewManager->getTopLeft().snap();
 	Position bottomRightBound = viewManager->getBottomRight().snap();
 
+	// only what is on screen, connections get a little margin for their curves. what gets drawn is
+	// copied out so no Block* is held past this point
+	struct VisibleBlock {
+		BlockType type;
+		Position position;
+		Rotation rotation;
+	};
+	struct VisibleConnection {
+		Position outputBlockPosition;
+		Position outputPosition;
+		Rotation outputRotation;
+		Position inputPosition;
+		Rotation inputRotation;
+		bool sameBlock;
+	};
+	const BlockContainer* blockContainer = circuit->getBlockContainer();
+	const std::vector<const Block*> blocksInArea = blockContainer->getBlocksInArea(topLeftBound, bottomRightBound);
+	std::vector<VisibleBlock> blocks;
+	blocks.reserve(blocksInArea.size());
+	for (const Block* block : blocksInArea) {
+		blocks.push_back({ block->type(), block->getPosition(), block->getRotation() });
+	}
+	std::vector<VisibleConnection> connections;
+	for (const auto& [outputEnd, inputEnd] : blockContainer->getConnectionsInArea(topLeftBound - Vector(2, 2), bottomRightBound + Vector(2, 2))) {
+		const Block* output = blockContainer->getBlock(outputEnd.getBlockId());
+		const Block* input = blockContainer->getBlock(inputEnd.getBlockId());
+		if (!output || !input) continue;
+		connections.push_back({
+			output->getPosition(),
+			output->getConnectionPosition(outputEnd.getConnectionId()).first,
+			output->getRotation(),
+			input->getConnectionPosition(inputEnd.getConnectionId()).first,
+			input->getRotation(),
+			output == input
+		});
+	}
+
 	if (evaluator) {
-		// get states
+		// get states, the visible blocks and then the outputs of the visible connections
 		std::vector<Address> blockAddresses;
-		std::vector<const Block*> blocks;
-		for (const auto& block : *(circuit->getBlockContainer())) {
-			blockAddresses.push_back(Address(block.second.getPosition()));
-			blocks.push_back(&(block.second));
+		blockAddresses.reserve(blocks.size() + connections.size());
+		for (const VisibleBlock& block : blocks) {
+			blockAddresses.push_back(Address(block.position));
+		}
+		for (const VisibleConnection& connection : connections) {
+			blockAddresses.push_back(Address(connection.outputBlockPosition));
 		}
 		std::vector<logic_state_t> blockStates = evaluator->getBulkStates(blockAddresses);
 
@@ -99,9 +138,7 @@ void QtRenderer::render(QPainter* painter) {
 		// render blocks
 		painter->setRenderHint(QPainter::SmoothPixmapTransform);
 		for (unsigned int i = 0; i < blocks.size(); i++) {
-			if (blocks[i]->getPosition().withinArea(topLeftBound, bottomRightBound) || blocks[i]->getLargestPosition().withinArea(topLeftBound, bottomRightBound)) {
-				renderBlock(painter, blocks[i]->type(), blocks[i]->getPosition(), blocks[i]->getRotation(), blockStates[i]);
-			}
+			renderBlock(painter, blocks[i].type, blocks[i].position, blocks[i].rotation, blockStates[i]);
 		}
 
 		// render block previews
@@ -116,26 +153,9 @@ void QtRenderer::render(QPainter* painter) {
 		painter->save();
 		painter->setOpacity(0.9f);
 		// painter->setRenderHint(QPainter::Antialiasing);
-		for (unsigned int i = 0; i < blocks.size(); i++) {
-			bool state = blockStates[i];
-			for (connection_end_id_t id = 0; id <= blocks[i]->getConnectionContainer().getMaxConnectionId(); id++) {
-				// continue if input, we only want outputs
-				if (blocks[i]->isConnectionInput(id)) continue;
-
-				Position pos = blocks[i]->getConnectionPosition(id).first;
-				for (auto connectionIter : blocks[i]->getConnectionContainer().getConnections(id)) {
-					const Block* other = circuit->getBlockContainer()->getBlock(connectionIter.getBlockId());
-					Position otherPos = other->getConnectionPosition(connectionIter.getConnectionId()).first;
-					if (
-						(pos.x + 2 > topLeftBound.x || otherPos.x + 2 > topLeftBound.x) &&
-						(pos.y + 2 > topLeftBound.y || otherPos.y + 2 > topLeftBound.y) &&
-						(pos.x - 2 < bottomRightBound.x || otherPos.x - 2 < bottomRightBound.x) &&
-						(pos.y - 2 < bottomRightBound.y || otherPos.y - 2 < bottomRightBound.y)
-					) {
-						renderConnection(painter, pos, blocks[i], otherPos, other, state);
-					}
-				}
-			}
+		for (unsigned int i = 0; i < connections.size(); i++) {
+			const VisibleConnection& connection = connections[i];
+			renderConnection(painter, connection.outputPosition, connection.outputRotation, connection.inputPosition, connection.inputRotation, connection.sameBlock, blockStates[blocks.size() + i]);
 		}
 		// render connection previews
 		for (const auto& preview : connectionPreviews) {
@@ -155,12 +175,8 @@ void QtRenderer::render(QPainter* painter) {
 		}
 
 		painter->setRenderHint(QPainter::SmoothPixmapTransform);
-		std::vector<const Block*> blocks;
-		for (const auto& block : *(circuit->getBlockContainer())) {
-			if (block.second.getPosition().withinArea(topLeftBound, bottomRightBound) || block.second.getLargestPosition().withinArea(topLeftBound, bottomRightBound)) {
-				renderBlock(painter, block.second.type(), block.second.getPosition(), block.second.getRotation());
-			}
-			blocks.push_back(&(block.second));
+		for (const VisibleBlock& block : blocks) {
+			renderBlock(painter, block.type, block.position, block.rotation);
 		}
 
 		// render block previews
@@ -175,25 +191,8 @@ void QtRenderer::render(QPainter* painter) {
 		painter->save();
 		painter->setOpacity(0.9f);
 		painter->setRenderHint(QPainter::Antialiasing);
-		for (unsigned int i = 0; i < blocks.size(); i++) {
-			for (connection_end_id_t id = 0; id <= blocks[i]->getConnectionContainer().getMaxConnectionId(); id++) {
-				// continue if input, we only want outputs
-				if (blocks[i]->isConnectionInput(id)) continue;
-
-				Position pos = blocks[i]->getConnectionPosition(id).first;
-				for (auto connectionIter : blocks[i]->getConnectionContainer().getConnections(id)) {
-					const Block* other = circuit->getBlockContainer()->getBlock(connectionIter.getBlockId());
-					Position otherPos = other->getConnectionPosition(connectionIter.getConnectionId()).first;
-					if (
-						(pos.x + 2 > topLeftBound.x || otherPos.x + 2 > topLeftBound.x) &&
-						(pos.y + 2 > topLeftBound.y || otherPos.y + 2 > topLeftBound.y) &&
-						(pos.x - 2 < bottomRightBound.x || otherPos.x - 2 < bottomRightBound.x) &&
-						(pos.y - 2 < bottomRightBound.y || otherPos.y - 2 < bottomRightBound.y)
-					) {
-						renderConnection(painter, pos, blocks[i], otherPos, other, false);
-					}
-				}
-			}
+		for (const VisibleConnection& connection : connections) {
+			renderConnection(painter, connection.outputPosition, connection.outputRotation, connection.inputPosition, connection.inputRotation, connection.sameBlock, false);
 		}
 		// render connection previews
 		for (const auto& preview : connectionPreviews) {
@@ -403,10 +402,10 @@ void QtRenderer::renderConnection(QPainter* painter, FPosition aPos, FPosition b
 const float edgeDis = 0.48f;
 const float sideShift = 0.25f;
 
-void QtRenderer::renderConnection(QPainter* painter, Position aPos, const Block* a, Position bPos, const Block* b, bool state) {
+void QtRenderer::renderConnection(QPainter* painter, Position aPos, std::optional<Rotation> aRotation, Position bPos, std::optional<Rotation> bRotation, bool sameBlock, bool state) {
 	FVector centerOffset(0.5f, 0.5f);
 
-	if (a == b) {
+	if (sameBlock) {
 		if (state) {
 			drawText(painter, gridToQt(aPos.free() + centerOffset), "S", 30, QColor(connectionON));
 		} else {
@@ -418,8 +417,8 @@ void QtRenderer::renderConnection(QPainter* painter, Position aPos, const Block*
 	FVector aSocketOffset(0.0f, 0.0f);
 	FVector bSocketOffset(0.0f, 0.0f);
 
-	if (a) {
-		switch (a->getRotation()) {
+	if (aRotation) {
+		switch (*aRotation) {
 		case Rotation::ZERO: aSocketOffset = { edgeDis, sideShift }; break;
 		case Rotation::NINETY: aSocketOffset = { -sideShift, edgeDis }; break;
 		case Rotation::ONE_EIGHTY: aSocketOffset = { -edgeDis, -sideShift }; break;
@@ -427,8 +426,8 @@ void QtRenderer::renderConnection(QPainter* painter, Position aPos, const Block*
 		}
 	}
 
-	if (b) {
-		switch (b->getRotation()) {
+	if (bRotation) {
+		switch (*bRotation) {
 		case Rotation::ZERO: bSocketOffset = { -edgeDis, -sideShift }; break;
 		case Rotation::NINETY: bSocketOffset = { sideShift, -edgeDis }; break;
 		case Rotation::ONE_EIGHTY: bSocketOffset = { edgeDis, sideShift }; break;
@@ -443,9 +442,10 @@ void QtRenderer::renderConnection(QPainter* painter, Position aPos, Position bPo
 	// Socket offsets will be retrieved data later, this code will go
 	const Block* a = circuit->getBlockContainer()->getBlock(aPos);
 	const Block* b = circuit->getBlockContainer()->getBlock(bPos);
+	std::optional<Rotation> aRotation = a ? std::optional<Rotation>(a->getRotation()) : std::nullopt;
+	std::optional<Rotation> bRotation = b ? std::optional<Rotation>(b->getRotation()) : std::nullopt;
 
-
-	renderConnection(painter, aPos, a, bPos, b, state);
+	renderConnection(painter, aPos, aRotation, bPos, bRotation, a && a == b, state);
 }
 
 void QtRenderer::renderConnection(QPainter* painter, Position aPos, FPosition bPos, bool state) {
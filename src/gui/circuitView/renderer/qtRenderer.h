@@ -51,7 +51,7 @@ private:
 	void renderSelection(QPainter* painter, const SharedSelection selection, SelectionObjectElement::RenderMode mode, unsigned int depth = 0);
 	void renderBlock(QPainter* painter, BlockType type, Position position, Rotation rotation, bool state = false);
 	void renderConnection(QPainter* painter, FPosition aPos, FPosition bPos, FVector aControlOffset, FVector bControlOffset, bool state);
-	void renderConnection(QPainter* painter, Position aPos, const Block* a, Position bPos, const Block* b, bool state);
+	void renderConnection(QPainter* painter, Position aPos, std::optional<Rotation> aRotation, Position bPos, std::optional<Rotation> bRotation, bool sameBlock, bool state);
 	void renderConnection(QPainter* painter, Position aPos, Position bPos, bool state);
 	void renderConnection(QPainter* painter, Position aPos, FPosition bPos, bool state);
 
@@ -38,6 +38,8 @@ CircuitViewWidget::CircuitViewWidget(QWidget* parent) : QWidget(parent), mouseCo
 
 	QShortcut* saveShortcut = new QShortcut(QKeySequence("Ctrl+S"), this);
 	connect(saveShortcut, &QShortcut::activated, this, &CircuitViewWidget::save);
+	QShortcut* metricsShortcut = new QShortcut(QKeySequence("Ctrl+M"), this);
+	connect(metricsShortcut, &QShortcut::activated, this, &CircuitViewWidget::saveMetrics);
 }
 
 void CircuitViewWidget::updateLoop() {
@@ -91,6 +93,27 @@ void CircuitViewWidget::paintEvent(QPaintEvent* event) {
 	std::string tpsStr = "tps: " + stream2.str();
 	painter->drawText(QRect(QPoint(0, 16), size()), Qt::AlignTop, QString(tpsStr.c_str()));
 
+	if constexpr (METRICS_ENABLED) {
+		// per tick averages since the last frame
+		const SimulatorMetrics metrics = circuitView.getEvaluatorStateInterface().getMetrics();
+		// the counters start over when the view gets another evaluator, the unsigned deltas would wrap
+		if (metrics.ticks < lastFrameMetrics.ticks) lastFrameMetrics = SimulatorMetrics();
+		const unsigned long long ticks = metrics.ticks - lastFrameMetrics.ticks;
+		if (ticks) {
+			const double computeUs = (metrics.computeTime_ns - lastFrameMetrics.computeTime_ns) / 1000.0 / ticks;
+			const double propagateUs = (metrics.propagateTime_ns - lastFrameMetrics.propagateTime_ns) / 1000.0 / ticks;
+			const double waitUs = (metrics.pauseWaitTime_ns - lastFrameMetrics.pauseWaitTime_ns) / 1000.0 / ticks;
+			const double toggled = (double)(metrics.gatesToggled - lastFrameMetrics.gatesToggled) / ticks;
+			std::stringstream stream3;
+			stream3 << std::fixed << std::setprecision(2) << "compute: " << computeUs << "us propagate: " << propagateUs << "us wait: " << waitUs << "us toggled: " << toggled;
+			painter->drawText(QRect(QPoint(0, 32), size()), Qt::AlignTop, QString(stream3.str().c_str()));
+		}
+		std::stringstream stream4;
+		stream4 << "edit queue: " << metrics.editQueueDepth << " max read wait: " << metrics.maxReadWait_ns / 1000 << "us";
+		painter->drawText(QRect(QPoint(0, 48), size()), Qt::AlignTop, QString(stream4.str().c_str()));
+		lastFrameMetrics = metrics;
+	}
+
 	delete painter;
 }
 
@@ -241,6 +264,11 @@ void CircuitViewWidget::save() {
 	saveJsonToFile(modificationsJson);
 }
 
+void CircuitViewWidget::saveMetrics() {
+	const SimulatorMetrics metrics = circuitView.getEvaluatorStateInterface().getMetrics();
+	saveJsonToFile(QJsonDocument::fromJson(QByteArray::fromStdString(metrics.toJson())).object());
+}
+
 void saveJsonToFile(const QJsonObject& jsonObject) {
 	// Convert JSON object to QJsonDocument
 	QJsonDocument jsonDoc(jsonObject);
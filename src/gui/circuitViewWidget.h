@@ -32,6 +32,7 @@ private:
 	// framerate statistics
 	std::list<float> pastFrameTimes;
 	const int numTimesInAverage = 20;
+	SimulatorMetrics lastFrameMetrics;
 
 	// ui elements
 	QTreeWidget* treeWidget;
@@ -40,6 +41,7 @@ private:
 	bool mouseControls;
 
 	void save();
+	void saveMetrics(); // simulator counters as json
 	void load(const QString& filePath);
 
 	// utility functions
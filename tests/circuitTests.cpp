@@ -123,3 +123,239 @@ TEST_F(CircuitTest, ConnectionRemoval) {
 	const BlockContainer* container = circuit->getBlockContainer();
 	ASSERT_FALSE(container->connectionExists(pos1, pos2));
 }
+
+TEST_F(CircuitTest, ChunkedGridMatchesMap) {
+	// same random edits on both backends, across chunk borders and negative coordinates
+	Sparse2dChunked<int> chunked;
+	Sparse2dArray<int> reference;
+	std::mt19937 random(11);
+	auto randomPosition = [&random]() { return Position((int)(random() % 200) - 100, (int)(random() % 200) - 100); };
+	for (int step = 0; step < 2000; ++step) {
+		Position small = randomPosition();
+		Position large = small + Vector(random() % 40, random() % 40);
+		switch (random() % 5) {
+		case 0: chunked.insert(small, step); reference.insert(small, step); break;
+		case 1: chunked.remove(small); reference.remove(small); break;
+		case 2: chunked.insertArea(small, large, step); reference.insertArea(small, large, step); break;
+		case 3: chunked.removeArea(small, large); reference.removeArea(small, large); break;
+		case 4: ASSERT_EQ(chunked.anyInArea(small, large), reference.anyInArea(small, large)) << "step " << step; break;
+		}
+		ASSERT_EQ(chunked.size(), reference.size()) << "step " << step;
+	}
+	const Sparse2dChunked<int> copy = chunked;
+	for (cord_t x = -100; x < 140; ++x) {
+		for (cord_t y = -100; y < 140; ++y) {
+			const int* expected = reference.get(Position(x, y));
+			const int* value = copy.get(Position(x, y));
+			ASSERT_EQ(value == nullptr, expected == nullptr) << Position(x, y).toString();
+			if (value) {
+				ASSERT_EQ(*value, *expected);
+			}
+		}
+	}
+}
+
+TEST_F(CircuitTest, GridBucketsFindBigValuesOnce) {
+	// values from a single cell to the whole coordinate range wide, checked against a plain overlap test
+	GridBuckets<int> index;
+	struct Area { Position small, large; };
+	std::vector<Area> areas;
+	std::mt19937 random(13);
+	for (int value = 0; value < 400; ++value) {
+		Position small((int)(random() % 600) - 300, (int)(random() % 600) - 300);
+		const cord_t extent = value % 4 == 0 ? 300 : 40;
+		Position large = small + Vector(random() % extent, random() % extent);
+		if (value % 25 == 0) {
+			small.x = std::numeric_limits<cord_t>::min();
+			large.x = std::numeric_limits<cord_t>::max();
+		}
+		index.insert(small, large, value);
+		areas.push_back({ small, large });
+	}
+	std::vector<uint8_t> removed(areas.size(), false);
+	for (int round = 0; round < 2; ++round) {
+		for (int query = 0; query < 200; ++query) {
+			const Position small((int)(random() % 700) - 350, (int)(random() % 700) - 350);
+			const Position large = small + Vector(random() % 100, random() % 100);
+			std::vector<int> found;
+			index.forEachInArea(small, large, [&found](int value) { found.push_back(value); });
+			std::sort(found.begin(), found.end());
+			std::vector<int> expected;
+			for (int value = 0; value < (int)areas.size(); ++value) {
+				const Area& area = areas[value];
+				if (!removed[value] && area.small.x <= large.x && small.x <= area.large.x && area.small.y <= large.y && small.y <= area.large.y) {
+					expected.push_back(value);
+				}
+			}
+			ASSERT_EQ(found, expected) << "round " << round << " query " << query;
+		}
+		if (round > 0) break;
+		// every other value goes, big ones have to leave all their buckets
+		for (int value = 0; value < (int)areas.size(); value += 2) {
+			ASSERT_TRUE(index.remove(areas[value].small, areas[value].large, value));
+			removed[value] = true;
+		}
+		ASSERT_FALSE(index.remove(areas[0].small, areas[0].large, 0));
+		ASSERT_EQ(index.size(), areas.size() / 2);
+	}
+}
+
+TEST_F(CircuitTest, SpatialQueriesFollowEdits) {
+	// blocks spread far apart with connections between neighbours, one of them very long
+	for (int x = 0; x < 20; ++x) {
+		ASSERT_TRUE(circuit->tryInsertBlock(Position(x * 50, x % 3), Rotation::ZERO, BlockType::AND));
+	}
+	for (int x = 0; x + 1 < 20; ++x) {
+		ASSERT_TRUE(circuit->tryCreateConnection(Position(x * 50, x % 3), Position((x + 1) * 50, (x + 1) % 3)));
+	}
+	ASSERT_TRUE(circuit->tryCreateConnection(Position(0, 0), Position(19 * 50, 19 % 3)));
+	const BlockContainer* container = circuit->getBlockContainer();
+
+	// only the blocks at x = 100 and 150
+	auto blocks = container->getBlocksInArea(Position(90, -5), Position(160, 5));
+	ASSERT_EQ(blocks.size(), 2);
+	// between them there is only the link from 100 to 150 and the long one passing over
+	ASSERT_EQ(container->getConnectionsInArea(Position(120, -5), Position(130, 5)).size(), 2);
+	// around them also the links coming from 50 and going to 200
+	ASSERT_EQ(container->getConnectionsInArea(Position(90, -5), Position(160, 5)).size(), 4);
+
+	// moved blocks and their connections are found at the new place only
+	ASSERT_TRUE(circuit->tryMoveBlock(Position(100, 2), Position(5000, 5000)));
+	ASSERT_EQ(container->getBlocksInArea(Position(90, -5), Position(160, 5)).size(), 1);
+	ASSERT_EQ(container->getBlocksInArea(Position(5000, 5000), Position(5000, 5000)).size(), 1);
+	ASSERT_EQ(container->getConnectionsInArea(Position(4000, 4000), Position(4990, 4990)).size(), 2);
+
+	// removing a block takes its connections with it
+	ASSERT_TRUE(circuit->tryRemoveBlock(Position(5000, 5000)));
+	ASSERT_TRUE(container->getBlocksInArea(Position(4000, 4000), Position(6000, 6000)).empty());
+	ASSERT_TRUE(container->getConnectionsInArea(Position(4000, 4000), Position(4990, 4990)).empty());
+	ASSERT_EQ(container->getConnectionsInArea(Position(-10000, -10000), Position(10000, 10000)).size(), 18);
+}
+
+TEST_F(CircuitTest, BlockIdsStayValid) {
+	for (int x = 0; x < 10; ++x) {
+		ASSERT_TRUE(circuit->tryInsertBlock(Position(x, 0), Rotation::ZERO, BlockType::AND));
+	}
+	const BlockContainer* container = circuit->getBlockContainer();
+	const block_id_t firstId = container->getBlock(Position(0, 0))->id();
+	const block_id_t lastId = container->getBlock(Position(9, 0))->id();
+	const Block* last = container->getBlock(Position(9, 0));
+	ASSERT_TRUE(circuit->tryCreateConnection(Position(9, 0), Position(5, 0)));
+
+	// the other blocks keep their ids, connections and addresses
+	ASSERT_TRUE(circuit->tryRemoveBlock(Position(0, 0)));
+	ASSERT_EQ(container->getBlock(firstId), nullptr);
+	ASSERT_EQ(container->getBlock(lastId), last);
+	ASSERT_EQ(last->getPosition(), Position(9, 0));
+	ASSERT_TRUE(container->connectionExists(Position(9, 0), Position(5, 0)));
+
+	// a new block can reuse the slot but not the id
+	ASSERT_TRUE(circuit->tryInsertBlock(Position(0, 0), Rotation::ZERO, BlockType::OR));
+	ASSERT_NE(container->getBlock(Position(0, 0))->id(), firstId);
+	ASSERT_EQ(container->getBlock(firstId), nullptr);
+
+	// more blocks than fit in one chunk dont move the ones already there
+	for (int x = 0; x < 5000; ++x) {
+		ASSERT_TRUE(circuit->tryInsertBlock(Position(x, 10), Rotation::ZERO, BlockType::AND));
+	}
+	ASSERT_EQ(container->getBlock(lastId), last);
+
+	// the slot runs out of generations long before this, after that it is not reused anymore
+	std::set<block_id_t> usedIds = { firstId };
+	for (int i = 0; i < 300; ++i) {
+		const block_id_t id = container->getBlock(Position(0, 0))->id();
+		ASSERT_TRUE(usedIds.insert(id).second) << "id reused after " << i << " removals";
+		ASSERT_TRUE(circuit->tryRemoveBlock(Position(0, 0)));
+		ASSERT_TRUE(circuit->tryInsertBlock(Position(0, 0), Rotation::ZERO, BlockType::OR));
+	}
+
+	unsigned int blockCount = 0;
+	for (const Block& block : *container) {
+		ASSERT_EQ(container->getBlock(block.id()), &block);
+		++blockCount;
+	}
+	ASSERT_EQ(blockCount, container->getBlockCount());
+}
+
+TEST_F(CircuitTest, TransactionsSendOneDifference) {
+	unsigned int sent = 0;
+	circuit->connectListener(this, [&](DifferenceSharedPtr, circuit_id_t) { ++sent; });
+	const BlockContainer* container = circuit->getBlockContainer();
+	ASSERT_TRUE(circuit->tryInsertBlock(Position(5, 5), Rotation::ZERO, BlockType::OR));
+	sent = 0;
+
+	// the area goes around the block already there
+	circuit->beginTransaction(100);
+	ASSERT_EQ(circuit->tryInsertOverArea(Position(0, 0), Position(9, 9), Rotation::ZERO, BlockType::AND), 99);
+	ASSERT_TRUE(circuit->tryCreateConnection(Position(0, 0), Position(1, 0)));
+	ASSERT_EQ(sent, 0);
+	circuit->commitTransaction();
+	ASSERT_EQ(sent, 1);
+	ASSERT_EQ(container->getBlockCount(), 100);
+	ASSERT_EQ(container->getBlock(Position(5, 5))->type(), BlockType::OR);
+
+	// the whole transaction is one undo step
+	circuit->undo();
+	ASSERT_EQ(container->getBlockCount(), 1);
+	circuit->redo();
+	ASSERT_EQ(container->getBlockCount(), 100);
+	ASSERT_TRUE(container->connectionExists(Position(0, 0), Position(1, 0)));
+
+	// aborting puts everything back without telling the listeners
+	sent = 0;
+	circuit->beginTransaction();
+	ASSERT_EQ(circuit->tryRemoveOverArea(Position(0, 0), Position(4, 9)), 50);
+	ASSERT_EQ(circuit->tryInsertOverArea(Position(20, 0), Position(29, 9), Rotation::ZERO, BlockType::XOR), 100);
+	// a move that is blocked fails inside a transaction too
+	ASSERT_FALSE(circuit->tryMoveBlock(Position(5, 0), Position(5, 1)));
+	ASSERT_TRUE(circuit->tryMoveBlock(Position(5, 0), Position(15, 0)));
+	ASSERT_THROW(circuit->undo(), std::logic_error);
+	ASSERT_THROW(circuit->beginTransaction(), std::logic_error);
+	circuit->abortTransaction();
+	ASSERT_EQ(sent, 0);
+	ASSERT_FALSE(circuit->inTransaction());
+	ASSERT_EQ(container->getBlockCount(), 100);
+	ASSERT_EQ(container->getBlock(Position(25, 5)), nullptr);
+	ASSERT_EQ(container->getBlock(Position(15, 0)), nullptr);
+	ASSERT_EQ(container->getBlock(Position(5, 0))->type(), BlockType::AND);
+	ASSERT_EQ(container->getBlock(Position(0, 0))->type(), BlockType::AND);
+	ASSERT_TRUE(container->connectionExists(Position(0, 0), Position(1, 0)));
+	ASSERT_THROW(circuit->commitTransaction(), std::logic_error);
+	circuit->disconnectListener(this);
+}
+
+TEST_F(CircuitTest, DifferenceDecodesWhatWasAdded) {
+	DifferenceSharedPtr sent;
+	circuit->connectListener(this, [&](DifferenceSharedPtr difference, circuit_id_t) { sent = difference; });
+	// far apart positions so deltas wrap around
+	const Position low(std::numeric_limits<cord_t>::min() + 3, -7);
+	const Position high(std::numeric_limits<cord_t>::max() - 3, 1 << 20);
+	circuit->beginTransaction();
+	ASSERT_TRUE(circuit->tryInsertBlock(low, Rotation::ZERO, BlockType::SWITCH));
+	ASSERT_TRUE(circuit->tryInsertBlock(high, Rotation::NINETY, BlockType::LIGHT));
+	ASSERT_TRUE(circuit->tryCreateConnection(low, high));
+	ASSERT_TRUE(circuit->trySetBlockData(high, 0xdeadbeef));
+	ASSERT_TRUE(circuit->tryMoveBlock(high, Position(-1, -1)));
+	ASSERT_TRUE(circuit->tryRemoveBlock(low));
+	circuit->commitTransaction();
+	circuit->disconnectListener(this);
+
+	std::vector<Difference::Modification> expected = {
+		{ Difference::PLACE_BLOCK, std::make_tuple(low, Rotation::ZERO, BlockType::SWITCH) },
+		{ Difference::PLACE_BLOCK, std::make_tuple(high, Rotation::NINETY, BlockType::LIGHT) },
+		{ Difference::CREATED_CONNECTION, std::make_pair(low, high) },
+		{ Difference::SET_DATA, std::make_tuple(high, (block_data_t)0xdeadbeef, (block_data_t)0) },
+		{ Difference::MOVE_BLOCK, std::make_pair(high, Position(-1, -1)) },
+		{ Difference::REMOVED_CONNECTION, std::make_pair(low, Position(-1, -1)) },
+		{ Difference::REMOVED_BLOCK, std::make_tuple(low, Rotation::ZERO, BlockType::SWITCH) },
+	};
+	const Difference::ModificationView modifications = sent->getModifications();
+	ASSERT_EQ(modifications.size(), expected.size());
+	ASSERT_EQ(std::vector<Difference::Modification>(modifications.begin(), modifications.end()), expected);
+	// undo walks it backwards
+	std::reverse(expected.begin(), expected.end());
+	ASSERT_EQ(std::vector<Difference::Modification>(modifications.rbegin(), modifications.rend()), expected);
+
+	circuit->undo();
+	ASSERT_EQ(circuit->getBlockContainer()->getBlockCount(), 0);
+}
@@ -2,6 +2,7 @@
 #define circuitTests_h
 
 #include <gtest/gtest.h>
+#include <random>
 #include "backend/circuit/circuit.h"
 
 class CircuitTest: public ::testing::Test {
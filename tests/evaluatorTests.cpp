@@ -92,6 +92,38 @@ TEST_F(EvaluatorTest, BulkStateOperations) {
 	}
 }
 
+TEST_F(EvaluatorTest, BulkReadsInAnyOrder) {
+	std::vector<Address> addresses;
+	for (int j = 0; j < 50; ++j) {
+		circuit->tryInsertBlock(Position(i + j, i), Rotation::ZERO, BlockType::SWITCH);
+		addresses.push_back(Address(Position(i + j, i)));
+		if (j % 3 == 0) evaluator->setState(addresses.back(), true);
+	}
+	i += 50;
+
+	// placed order, backwards and every other one repeated
+	std::vector<Address> reversed(addresses.rbegin(), addresses.rend());
+	std::vector<Address> repeated;
+	for (int j = 0; j < 50; j += 2) {
+		repeated.push_back(addresses[j]);
+		repeated.push_back(addresses[j]);
+	}
+	const std::vector<logic_state_t> states = evaluator->getBulkStates(addresses);
+	const std::vector<logic_state_t> reversedStates = evaluator->getBulkStates(reversed);
+	const std::vector<logic_state_t> repeatedStates = evaluator->getBulkStates(repeated);
+	for (int j = 0; j < 50; ++j) {
+		ASSERT_EQ(states[j], j % 3 == 0);
+		ASSERT_EQ(reversedStates[49 - j], j % 3 == 0);
+		if (j % 2 == 0) {
+			ASSERT_EQ(repeatedStates[j], j % 3 == 0);
+			ASSERT_EQ(repeatedStates[j + 1], j % 3 == 0);
+		}
+	}
+
+	addresses.push_back(Address(Position(i, i + 1)));
+	ASSERT_THROW(evaluator->getBulkStates(addresses), std::out_of_range);
+}
+
 TEST_F(EvaluatorTest, LogicGateEvaluation) {
 	// AND gate with two inputs
 	Position andPos(i, i); ++i;
@@ -233,3 +265,186 @@ TEST_F(EvaluatorTest, FastCircuitModifications) {
 		ASSERT_NO_THROW(evaluator->getState(addr));
 	}
 }
+
+TEST_F(EvaluatorTest, QueuedEditsWhileRunning) {
+	evaluator->setUseTickrate(false);
+	evaluator->setPause(false);
+
+	// place a row of switches and delete every other one while the simulation runs
+	std::vector<Position> positions;
+	for (int j = 0; j < 600; ++j) {
+		positions.emplace_back(i, 0); ++i;
+		circuit->tryInsertBlock(positions.back(), Rotation::ZERO, BlockType::SWITCH);
+	}
+	for (int j = 0; j < 600; j += 2) {
+		circuit->tryRemoveBlock(positions[j]);
+	}
+	for (int j = 1; j < 600; j += 2) {
+		evaluator->setState(Address(positions[j]), j % 4 == 1);
+	}
+
+	std::vector<Address> addresses;
+	for (int j = 1; j < 600; j += 2) {
+		addresses.push_back(Address(positions[j]));
+	}
+	// reads see every edit made before them
+	std::vector<logic_state_t> states = evaluator->getBulkStates(addresses);
+	for (int j = 1; j < 600; j += 2) {
+		ASSERT_EQ(states[j / 2], j % 4 == 1);
+	}
+
+	evaluator->setPause(true);
+}
+
+TEST_F(EvaluatorTest, EditErrorsReachTheCaller) {
+	ASSERT_THROW(evaluator->setState(Address(Position(100, 100)), true), std::out_of_range);
+	ASSERT_THROW(evaluator->setLaneStates({ Address(Position(100, 100)) }, { 1 }), std::out_of_range);
+
+	// a difference removing a block this evaluator never saw
+	Circuit otherCircuit(2);
+	DifferenceSharedPtr removal;
+	otherCircuit.tryInsertBlock(Position(100, 100), Rotation::ZERO, BlockType::AND);
+	otherCircuit.connectListener(this, [&](DifferenceSharedPtr difference, circuit_id_t) { removal = difference; });
+	otherCircuit.tryRemoveBlock(Position(100, 100));
+	ASSERT_THROW(evaluator->makeEdit(removal, 1).get(), std::out_of_range);
+
+	// the simulation thread keeps going
+	circuit->tryInsertBlock(Position(0, 0), Rotation::ZERO, BlockType::SWITCH);
+	evaluator->setState(Address(Position(0, 0)), true);
+	ASSERT_EQ(evaluator->getState(Address(Position(0, 0))), true);
+}
+
+TEST_F(EvaluatorTest, LaneBatchEvaluation) {
+	Position andPos(i, i); ++i;
+	Position in1(i, i); ++i;
+	Position in2(i, i); ++i;
+	circuit->tryInsertBlock(andPos, Rotation::ZERO, BlockType::AND);
+	circuit->tryInsertBlock(in1, Rotation::ZERO, BlockType::SWITCH);
+	circuit->tryInsertBlock(in2, Rotation::ZERO, BlockType::SWITCH);
+	circuit->tryCreateConnection(in1, andPos);
+	circuit->tryCreateConnection(in2, andPos);
+
+	// every lane gets a different pair of inputs
+	const lane_word_t inputs1 = 0xF0F0F0F0F0F0F0F0ull;
+	const lane_word_t inputs2 = 0xFF00FF00FF00FF00ull;
+	evaluator->setLaneStates({Address(in1), Address(in2)}, {inputs1, inputs2});
+	evaluator->runLaneTicks(1);
+	std::vector<lane_word_t> outputs = evaluator->getLaneStates({Address(andPos)});
+	ASSERT_EQ(outputs.size(), 1);
+	ASSERT_EQ(outputs[0], inputs1 & inputs2);
+
+	// the live states are untouched
+	ASSERT_EQ(evaluator->getState(Address(andPos)), false);
+
+	ASSERT_THROW(evaluator->getLaneStates({Address(Position(i + 100, i))}), std::out_of_range);
+}
+
+TEST_F(EvaluatorTest, RunNTicksWhilePaused) {
+	// a nor gate feeding itself flips every tick
+	Position pos(i, i); ++i;
+	circuit->tryInsertBlock(pos, Rotation::ZERO, BlockType::NOR);
+	circuit->tryCreateConnection(pos, pos);
+	Address addr(pos);
+
+	evaluator->setTickrate(60); // one tick a second if it were paced
+	evaluator->setUseTickrate(true);
+	const auto start = std::chrono::steady_clock::now();
+	evaluator->runNTicks(1000000).wait();
+	ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(10));
+
+	const logic_state_t state = evaluator->getState(addr);
+	evaluator->runNTicks(1).wait();
+	ASSERT_NE(evaluator->getState(addr), state);
+	std::future<void> first = evaluator->runNTicks(3);
+	std::future<void> second = evaluator->runNTicks(2);
+	second.wait();
+	ASSERT_EQ(first.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+	ASSERT_EQ(evaluator->getState(addr), state); // six ticks in total
+	// paused so nothing else ran
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	ASSERT_EQ(evaluator->getState(addr), state);
+}
+
+TEST_F(EvaluatorTest, RemovalsKeepAddressesValid) {
+	// switch to light pairs, the blocks added last get moved into the holes of the removed ones
+	const int pairs = 20;
+	for (int x = 0; x < pairs; ++x) {
+		circuit->tryInsertBlock(Position(x, 0), Rotation::ZERO, BlockType::SWITCH);
+		circuit->tryInsertBlock(Position(x, 1), Rotation::ZERO, BlockType::OR);
+		circuit->tryCreateConnection(Position(x, 0), Position(x, 1));
+	}
+	for (int x = 0; x < pairs; x += 3) {
+		circuit->tryRemoveBlock(Position(x, 0));
+		circuit->tryRemoveBlock(Position(x, 1));
+	}
+	for (int x = 0; x < pairs; ++x) {
+		if (x % 3 == 0) continue;
+		evaluator->setState(Address(Position(x, 0)), x % 2);
+	}
+	evaluator->runNTicks(2).wait();
+	for (int x = 0; x < pairs; ++x) {
+		if (x % 3 == 0) continue;
+		ASSERT_EQ(evaluator->getState(Address(Position(x, 0))), x % 2) << "switch " << x;
+		ASSERT_EQ(evaluator->getState(Address(Position(x, 1))), x % 2) << "light " << x;
+	}
+}
+
+TEST_F(EvaluatorTest, GateHandlesSurviveRemovals) {
+	const int count = 10;
+	for (int x = 0; x < count; ++x) {
+		circuit->tryInsertBlock(Position(x, 0), Rotation::ZERO, BlockType::SWITCH);
+		evaluator->setState(Address(Position(x, 0)), x % 2);
+	}
+	std::vector<GateHandle> handles;
+	for (int x = 0; x < count; ++x) {
+		handles.push_back(evaluator->getGateHandle(Address(Position(x, 0))));
+	}
+	// the last switches get moved into the holes but their handles still find them
+	circuit->tryRemoveBlock(Position(0, 0));
+	circuit->tryRemoveBlock(Position(3, 0));
+	for (int x = 0; x < count; ++x) {
+		if (x == 0 || x == 3) {
+			ASSERT_THROW(evaluator->getState(handles[x]), std::out_of_range);
+		} else {
+			ASSERT_EQ(evaluator->getState(handles[x]), x % 2) << "switch " << x;
+		}
+	}
+	// a new block reuses the slot but not the generation of the removed one
+	circuit->tryInsertBlock(Position(0, 0), Rotation::ZERO, BlockType::SWITCH);
+	ASSERT_THROW(evaluator->getState(handles[0]), std::out_of_range);
+	ASSERT_NE(evaluator->getGateHandle(Address(Position(0, 0))), handles[0]);
+	std::vector<GateHandle> kept = { handles[9], handles[1] };
+	ASSERT_EQ(evaluator->getBulkStates(kept), std::vector<logic_state_t>({ true, true }));
+}
+
+TEST_F(EvaluatorTest, ReorderKeepsAddressesAndHandles) {
+	const int pairs = 20;
+	for (int x = 0; x < pairs; ++x) {
+		circuit->tryInsertBlock(Position(x, 0), Rotation::ZERO, BlockType::SWITCH);
+		circuit->tryInsertBlock(Position(x, 1), Rotation::ZERO, BlockType::OR);
+		circuit->tryCreateConnection(Position(x, 0), Position(x, 1));
+		evaluator->setState(Address(Position(x, 0)), x % 2);
+	}
+	const GateHandle handle = evaluator->getGateHandle(Address(Position(pairs - 1, 1)));
+	evaluator->reorderGates();
+	evaluator->runNTicks(2).wait();
+	for (int x = 0; x < pairs; ++x) {
+		ASSERT_EQ(evaluator->getState(Address(Position(x, 0))), x % 2) << "switch " << x;
+		ASSERT_EQ(evaluator->getState(Address(Position(x, 1))), x % 2) << "light " << x;
+	}
+	ASSERT_EQ(evaluator->getState(handle), (pairs - 1) % 2);
+}
+
+TEST_F(EvaluatorTest, AutoReorderWhilePaused) {
+	// enough new blocks for the idle reorder to run once the edit is applied
+	const int side = 72;
+	circuit->tryInsertOverArea(Position(0, 0), Position(side - 1, side - 1), Rotation::ZERO, BlockType::SWITCH);
+	for (int x = 0; x < side; x += 7) {
+		evaluator->setState(Address(Position(x, x)), true);
+	}
+	evaluator->runNTicks(1).wait();
+	for (int x = 0; x < side; ++x) {
+		ASSERT_EQ(evaluator->getState(Address(Position(x, x))), x % 7 == 0) << "switch " << x;
+		ASSERT_FALSE(evaluator->getState(Address(Position(x, (x + 1) % side))));
+	}
+}
@@ -9,6 +9,35 @@ void SimulatorTest::TearDown() {
 	simulator.clearGates();
 }
 
+const std::vector<GateType> SimulatorTest::ANY_GATE_TYPES = {
+	GateType::AND, GateType::OR, GateType::XOR, GateType::NAND, GateType::NOR, GateType::XNOR,
+	GateType::DEFAULT_RETURN_CURRENTSTATE, GateType::TICK_INPUT, GateType::CONSTANT_ON
+};
+
+const std::vector<GateType> SimulatorTest::LOGIC_GATE_TYPES = {
+	GateType::AND, GateType::OR, GateType::XOR, GateType::NAND, GateType::NOR, GateType::XNOR
+};
+
+std::mt19937 SimulatorTest::buildRandomCircuit(const std::vector<LogicSimulator*>& simulators, int gateCount, int edgeCount, unsigned int seed,
+	const std::vector<GateType>& types, int inputCount, bool acyclic) {
+	std::mt19937 random(seed);
+	for (int i = 0; i < gateCount; ++i) {
+		const GateType type = i < inputCount ? GateType::DEFAULT_RETURN_CURRENTSTATE : types[random() % types.size()];
+		for (LogicSimulator* sim : simulators) {
+			EXPECT_EQ(sim->addGate(type), (block_id_t)i);
+		}
+	}
+	for (int i = 0; i < edgeCount; ++i) {
+		const block_id_t from = random() % gateCount;
+		const block_id_t to = inputCount + random() % (gateCount - inputCount);
+		if (acyclic && from >= to) continue;
+		for (LogicSimulator* sim : simulators) {
+			sim->connectGates(from, to);
+		}
+	}
+	return random;
+}
+
 TEST_F(SimulatorTest, BasicGateOperations) {
 	block_id_t andGate = simulator.addGate(GateType::AND);
 	ASSERT_EQ(simulator.getState(andGate), false);
@@ -160,3 +189,511 @@ TEST_F(SimulatorTest, StateManagement) {
 	auto currentState = simulator.getCurrentState();
 	ASSERT_EQ(currentState.size(), 6);
 }
+
+TEST_F(SimulatorTest, EventDrivenMatchesSweep) {
+	LogicSimulator eventSimulator;
+	eventSimulator.setEvaluationMode(EvaluationMode::EVENT_DRIVEN);
+	std::mt19937 random = buildRandomCircuit({ &simulator, &eventSimulator }, 300, 600, 42);
+
+	for (int tick = 0; tick < 200; ++tick) {
+		if (tick % 7 == 0) {
+			block_id_t gate = random() % simulator.getCurrentState().size();
+			bool state = random() % 2;
+			simulator.setState(gate, state);
+			eventSimulator.setState(gate, state);
+		}
+		if (tick % 23 == 0) {
+			block_id_t from = random() % simulator.getCurrentState().size();
+			block_id_t to = random() % simulator.getCurrentState().size();
+			simulator.connectGates(from, to);
+			eventSimulator.connectGates(from, to);
+		}
+		if (tick == 100) {
+			simulator.decomissionGate(5);
+			eventSimulator.decomissionGate(5);
+			ASSERT_EQ(simulator.compressGates(), eventSimulator.compressGates());
+		}
+		simulator.simulateNTicks(1);
+		eventSimulator.simulateNTicks(1);
+		ASSERT_EQ(simulator.getCurrentState(), eventSimulator.getCurrentState()) << "diverged on tick " << tick;
+	}
+}
+
+TEST_F(SimulatorTest, PackedKernelMatchesReference) {
+	// the per gate logic from before gate evaluation was packed
+	auto reference = [](GateType gateType, unsigned int powered, unsigned int total, bool current) -> bool {
+		unsigned int type = (unsigned int)gateType;
+		if (type > 7) return ((type & 1) ^ (powered == total)) && total;
+		if (type > 5) return (!((powered & 1) || (powered && (type & 1)))) && total;
+		if (type > 3) return (powered & 1) || (powered && (type & 1));
+		if (type > 1) return type & 1;
+		return current;
+	};
+
+	const std::vector<GateType> types = {
+		GateType::NONE, GateType::AND, GateType::OR, GateType::XOR, GateType::NAND, GateType::NOR, GateType::XNOR,
+		GateType::DEFAULT_RETURN_CURRENTSTATE, GateType::TICK_INPUT, GateType::CONSTANT_ON
+	};
+	std::mt19937 random(7);
+	for (int iteration = 0; iteration < 100; ++iteration) {
+		GateTypeMasks masks;
+		std::vector<GateType> gateTypes(STATE_WORD_BITS);
+		std::vector<unsigned int> powered(STATE_WORD_BITS), total(STATE_WORD_BITS);
+		state_word_t current = ((state_word_t)random() << 32) | random();
+		for (unsigned int i = 0; i < STATE_WORD_BITS; ++i) {
+			gateTypes[i] = types[random() % types.size()];
+			masks.setType(i, gateTypes[i]);
+			total[i] = random() % 4;
+			powered[i] = total[i] ? random() % (total[i] + 1) : 0;
+		}
+		const state_word_t packed = combineGateWord(masks, computeInputWords(powered.data(), total.data()), current);
+		const state_word_t scalar = combineGateWord(masks, computeInputWordsScalar(powered.data(), total.data(), STATE_WORD_BITS), current);
+		ASSERT_EQ(packed, scalar);
+		for (unsigned int i = 0; i < STATE_WORD_BITS; ++i) {
+			ASSERT_EQ((bool)((packed >> i) & 1), reference(gateTypes[i], powered[i], total[i], (current >> i) & 1)) << "gate type " << (int)gateTypes[i];
+		}
+	}
+}
+
+TEST_F(SimulatorTest, ConnectionsRecompiledAfterEdits) {
+	block_id_t input = simulator.addGate(GateType::DEFAULT_RETURN_CURRENTSTATE);
+	block_id_t or1 = simulator.addGate(GateType::OR);
+	simulator.connectGates(input, or1);
+	simulator.setState(input, true);
+	simulator.simulateNTicks(1);
+	ASSERT_TRUE(simulator.getState(or1));
+
+	// new gates and connections after the connections were compiled
+	block_id_t or2 = simulator.addGate(GateType::OR);
+	simulator.connectGates(or1, or2);
+	simulator.simulateNTicks(1);
+	ASSERT_TRUE(simulator.getState(or2));
+
+	simulator.setState(input, false);
+	simulator.simulateNTicks(2);
+	ASSERT_FALSE(simulator.getState(or1));
+	ASSERT_FALSE(simulator.getState(or2));
+}
+
+TEST_F(SimulatorTest, ParallelSweepMatchesSerial) {
+	LogicSimulator parallelSimulator;
+	parallelSimulator.setWorkerCount(4);
+	// big enough to be split between the workers
+	const int gateCount = LogicSimulator::PARALLEL_MIN_GATES * 2 + 17;
+	std::mt19937 random = buildRandomCircuit({ &simulator, &parallelSimulator }, gateCount, gateCount * 3, 3);
+
+	for (int tick = 0; tick < 100; ++tick) {
+		if (tick % 5 == 0) {
+			block_id_t gate = random() % gateCount;
+			bool state = random() % 2;
+			simulator.setState(gate, state);
+			parallelSimulator.setState(gate, state);
+		}
+		if (tick == 50) {
+			parallelSimulator.setWorkerCount(3);
+		}
+		simulator.simulateNTicks(1);
+		parallelSimulator.simulateNTicks(1);
+		ASSERT_EQ(simulator.getCurrentState(), parallelSimulator.getCurrentState()) << "diverged on tick " << tick;
+	}
+}
+
+TEST_F(SimulatorTest, SnapshotFollowsTicks) {
+	block_id_t input = simulator.addGate(GateType::DEFAULT_RETURN_CURRENTSTATE);
+	block_id_t notGate = simulator.addGate(GateType::NOR);
+	simulator.connectGates(input, notGate);
+	simulator.publishSnapshot();
+	auto readStates = [this]() {
+		return simulator.readSnapshot([](const StateVector& states) { return states.toVector(); });
+	};
+	ASSERT_EQ(readStates(), std::vector<logic_state_t>({false, false}));
+
+	simulator.simulateNTicks(1);
+	ASSERT_EQ(readStates(), simulator.getCurrentState());
+	ASSERT_EQ(readStates(), std::vector<logic_state_t>({false, true}));
+
+	// edits are only seen once published
+	simulator.setState(input, true);
+	ASSERT_EQ(readStates(), std::vector<logic_state_t>({false, true}));
+	simulator.publishSnapshot();
+	ASSERT_EQ(readStates(), std::vector<logic_state_t>({true, true}));
+	simulator.simulateNTicks(1);
+	ASSERT_EQ(readStates(), std::vector<logic_state_t>({true, false}));
+}
+
+TEST_F(SimulatorTest, DecomissionedSlotsReused) {
+	const auto start = std::chrono::steady_clock::now();
+	std::mt19937 random(11);
+	std::vector<block_id_t> liveGates;
+	for (int i = 0; i < 1000000; ++i) {
+		liveGates.push_back(simulator.addGate(GateType::AND));
+		if (i % 3 == 2) {
+			// remove two random live gates, the next gate gets the last slot freed
+			for (int j = 0; j < 2; ++j) {
+				const unsigned int index = random() % liveGates.size();
+				simulator.decomissionGate(liveGates[index]);
+				liveGates[index] = liveGates.back();
+				liveGates.pop_back();
+			}
+		}
+	}
+	ASSERT_EQ(liveGates.size(), 1000000 - 2 * 333333);
+	// freed slots are filled before the arrays grow
+	ASSERT_EQ(simulator.getDecomissionedCount(), simulator.getGateCount() - liveGates.size());
+	ASSERT_LE(simulator.getDecomissionedCount(), 2);
+	// reusing a slot is constant time so this is nowhere near the limit
+	ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(10));
+}
+
+TEST_F(SimulatorTest, WideFanoutWiring) {
+	const auto start = std::chrono::steady_clock::now();
+	const int sinkCount = 100000;
+	block_id_t clock = simulator.addGate(GateType::CONSTANT_ON);
+	block_id_t reset = simulator.addGate(GateType::CONSTANT_ON);
+	std::vector<block_id_t> sinks;
+	for (int i = 0; i < sinkCount; ++i) {
+		sinks.push_back(simulator.addGate(GateType::AND));
+		simulator.connectGates(clock, sinks.back());
+		simulator.connectGates(reset, sinks.back());
+		simulator.connectGates(clock, sinks.back()); // duplicate is ignored
+	}
+	// remove out of order so the swap removes move edges around
+	for (int i = sinkCount - 1; i >= 0; i -= 3) {
+		simulator.disconnectGates(reset, sinks[i]);
+	}
+	for (int i = 0; i < sinkCount; i += 3) {
+		simulator.disconnectGates(clock, sinks[i]);
+		simulator.disconnectGates(clock, sinks[i]); // already gone
+	}
+	ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(10));
+
+	simulator.simulateNTicks(2);
+	std::vector<logic_state_t> states = simulator.getCurrentState();
+	for (int i = 0; i < sinkCount; ++i) {
+		const bool hasClock = i % 3 != 0;
+		const bool hasReset = (sinkCount - 1 - i) % 3 != 0;
+		ASSERT_EQ(states[sinks[i]], hasClock || hasReset) << "sink " << i;
+	}
+
+	// the edges left are still consistent after removing the drivers
+	simulator.decomissionGate(clock);
+	simulator.decomissionGate(reset);
+	simulator.simulateNTicks(2);
+	states = simulator.getCurrentState();
+	for (int i = 0; i < sinkCount; ++i) {
+		ASSERT_FALSE(states[sinks[i]]) << "sink " << i;
+	}
+}
+
+TEST_F(SimulatorTest, LevelizedSettlesAcyclicLogic) {
+	simulator.setEvaluationMode(EvaluationMode::LEVELIZED);
+	block_id_t input = simulator.addGate(GateType::DEFAULT_RETURN_CURRENTSTATE);
+	// a chain of inverters
+	std::vector<block_id_t> chain;
+	block_id_t previous = input;
+	for (int i = 0; i < 10; ++i) {
+		chain.push_back(simulator.addGate(GateType::NOR));
+		simulator.connectGates(previous, chain.back());
+		previous = chain.back();
+	}
+	simulator.simulateNTicks(1);
+	for (int i = 0; i < 10; ++i) {
+		ASSERT_EQ(simulator.getState(chain[i]), i % 2 == 0);
+	}
+	simulator.setState(input, true);
+	simulator.simulateNTicks(1);
+	for (int i = 0; i < 10; ++i) {
+		ASSERT_EQ(simulator.getState(chain[i]), i % 2 == 1);
+	}
+}
+
+TEST_F(SimulatorTest, LevelizedMatchesSettledSweep) {
+	LogicSimulator levelizedSimulator;
+	levelizedSimulator.setEvaluationMode(EvaluationMode::LEVELIZED);
+	const int inputCount = 16;
+	const int gateCount = 400;
+	std::mt19937 random = buildRandomCircuit({ &simulator, &levelizedSimulator }, gateCount, gateCount * 2, 5, LOGIC_GATE_TYPES, inputCount, true);
+
+	for (int round = 0; round < 10; ++round) {
+		for (block_id_t gate = 0; gate < inputCount; ++gate) {
+			bool state = random() % 2;
+			simulator.setState(gate, state);
+			levelizedSimulator.setState(gate, state);
+		}
+		// the sweep needs a tick per level, the levelized simulator settles in one
+		simulator.simulateNTicks(gateCount);
+		levelizedSimulator.simulateNTicks(1);
+		ASSERT_EQ(simulator.getCurrentState(), levelizedSimulator.getCurrentState()) << "round " << round;
+	}
+}
+
+TEST_F(SimulatorTest, LevelizedKeepsFeedbackDelay) {
+	LogicSimulator levelizedSimulator;
+	levelizedSimulator.setEvaluationMode(EvaluationMode::LEVELIZED);
+	// ring oscillator of three inverters with an inverter hanging off of it
+	for (LogicSimulator* sim : {&simulator, &levelizedSimulator}) {
+		for (int i = 0; i < 4; ++i) sim->addGate(GateType::NOR);
+		sim->connectGates(0, 1);
+		sim->connectGates(1, 2);
+		sim->connectGates(2, 0);
+		sim->connectGates(0, 3);
+	}
+	for (int tick = 0; tick < 20; ++tick) {
+		simulator.simulateNTicks(1);
+		levelizedSimulator.simulateNTicks(1);
+		for (block_id_t gate = 0; gate < 3; ++gate) {
+			ASSERT_EQ(simulator.getState(gate), levelizedSimulator.getState(gate)) << "tick " << tick;
+		}
+		// the gate outside the loop follows the loop on the same tick
+		ASSERT_EQ(levelizedSimulator.getState(3), !levelizedSimulator.getState(0)) << "tick " << tick;
+	}
+}
+
+TEST_F(SimulatorTest, LanesMatchSingleRuns) {
+	const int inputCount = 8;
+	const int gateCount = 200;
+	std::mt19937 random = buildRandomCircuit({ &simulator }, gateCount, gateCount * 2, 9, ANY_GATE_TYPES, inputCount);
+	std::vector<lane_word_t> inputLanes;
+	for (block_id_t gate = 0; gate < inputCount; ++gate) {
+		inputLanes.push_back(((lane_word_t)random() << 32) | random());
+		simulator.setLaneStates(gate, inputLanes[gate]);
+	}
+	const int tickCount = 20;
+	std::vector<std::vector<lane_word_t>> laneHistory;
+	for (int tick = 0; tick < tickCount; ++tick) {
+		simulator.simulateLaneTicks(1);
+		laneHistory.emplace_back();
+		for (block_id_t gate = 0; gate < gateCount; ++gate) {
+			laneHistory.back().push_back(simulator.getLaneStates(gate));
+		}
+	}
+
+	// each lane has to match running its inputs through the normal simulation
+	for (unsigned int lane = 0; lane < LANE_COUNT; ++lane) {
+		simulator.initialize();
+		for (block_id_t gate = 0; gate < inputCount; ++gate) {
+			simulator.setState(gate, (inputLanes[gate] >> lane) & 1);
+		}
+		for (int tick = 0; tick < tickCount; ++tick) {
+			simulator.simulateNTicks(1);
+			for (block_id_t gate = 0; gate < gateCount; ++gate) {
+				ASSERT_EQ(simulator.getState(gate), (laneHistory[tick][gate] >> lane) & 1) << "lane " << lane << " tick " << tick << " gate " << gate;
+			}
+		}
+	}
+}
+
+TEST_F(SimulatorTest, SteadyStateSkipsTicks) {
+	block_id_t input = simulator.addGate(GateType::DEFAULT_RETURN_CURRENTSTATE);
+	block_id_t inverter = simulator.addGate(GateType::NOR);
+	simulator.connectGates(input, inverter);
+	auto readState = [this](block_id_t gate) {
+		return simulator.readSnapshot([gate](const StateVector& states) { return gate < states.size() && states[gate]; });
+	};
+
+	simulator.setTargetTickrate(60 * 1000);
+	simulator.signalToProceed();
+	// once settled the rest of these change nothing so they dont have to run
+	const auto start = std::chrono::steady_clock::now();
+	simulator.queueTicks(1000000000000ull).wait();
+	ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+	ASSERT_TRUE(readState(inverter));
+
+	// edits wake it back up
+	simulator.queueEdit([this, input]() { simulator.setState(input, true); });
+	simulator.flushEdits();
+	simulator.queueTicks(2).wait();
+	ASSERT_FALSE(readState(inverter));
+
+	// skipped ticks are still counted. the rate is measured over whole seconds and the one with the queued
+	// ticks is far over, so wait for a second spent idling
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	long long int tickrate = simulator.getRealTickrate();
+	while ((tickrate <= 500 || tickrate >= 1500) && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		tickrate = simulator.getRealTickrate();
+	}
+	ASSERT_GT(tickrate, 500);
+	ASSERT_LT(tickrate, 1500);
+
+	simulator.waitForPause();
+}
+
+TEST_F(SimulatorTest, UniformKernelsMatchMasks) {
+	std::mt19937 random(11);
+	for (GateType type : ANY_GATE_TYPES) {
+		GateTypeMasks masks;
+		for (unsigned int i = 0; i < STATE_WORD_BITS; ++i) {
+			masks.setType(i, type);
+		}
+		ASSERT_EQ(getUniformGateType(masks), type);
+		for (int iteration = 0; iteration < 20; ++iteration) {
+			std::vector<unsigned int> powered(STATE_WORD_BITS), total(STATE_WORD_BITS);
+			state_word_t current = ((state_word_t)random() << 32) | random();
+			for (unsigned int i = 0; i < STATE_WORD_BITS; ++i) {
+				total[i] = random() % 4;
+				powered[i] = total[i] ? random() % (total[i] + 1) : 0;
+			}
+			const state_word_t mixed = combineGateWord(masks, computeInputWords(powered.data(), total.data()), current);
+			state_word_t uniform = 0;
+			switch (type) {
+			case GateType::AND: uniform = computeUniformGateWord<GateType::AND>(powered.data(), total.data(), current); break;
+			case GateType::OR: uniform = computeUniformGateWord<GateType::OR>(powered.data(), total.data(), current); break;
+			case GateType::XOR: uniform = computeUniformGateWord<GateType::XOR>(powered.data(), total.data(), current); break;
+			case GateType::NAND: uniform = computeUniformGateWord<GateType::NAND>(powered.data(), total.data(), current); break;
+			case GateType::NOR: uniform = computeUniformGateWord<GateType::NOR>(powered.data(), total.data(), current); break;
+			case GateType::XNOR: uniform = computeUniformGateWord<GateType::XNOR>(powered.data(), total.data(), current); break;
+			case GateType::CONSTANT_ON: uniform = computeUniformGateWord<GateType::CONSTANT_ON>(powered.data(), total.data(), current); break;
+			case GateType::TICK_INPUT: uniform = computeUniformGateWord<GateType::TICK_INPUT>(powered.data(), total.data(), current); break;
+			default: uniform = computeUniformGateWord<GateType::DEFAULT_RETURN_CURRENTSTATE>(powered.data(), total.data(), current); break;
+			}
+			ASSERT_EQ(uniform, mixed) << "gate type " << (int)type;
+		}
+	}
+	// one odd gate out means the word has to use the masks
+	GateTypeMasks masks;
+	for (unsigned int i = 0; i < STATE_WORD_BITS; ++i) {
+		masks.setType(i, i == 17 ? GateType::NAND : GateType::AND);
+	}
+	ASSERT_FALSE(getUniformGateType(masks).has_value());
+}
+
+TEST_F(SimulatorTest, CompressGroupsTypes) {
+	LogicSimulator reference;
+	const int gateCount = 2000;
+	std::mt19937 random = buildRandomCircuit({ &simulator, &reference }, gateCount, gateCount * 3, 3);
+	for (int i = 0; i < gateCount / 10; ++i) {
+		block_id_t gate = random() % gateCount;
+		simulator.setState(gate, true);
+		reference.setState(gate, true);
+	}
+	for (int i = 0; i < gateCount / 5; ++i) {
+		block_id_t gate = random() % gateCount;
+		simulator.decomissionGate(gate);
+		reference.decomissionGate(gate);
+	}
+	simulator.simulateNTicks(5);
+	reference.simulateNTicks(5);
+
+	// only one side is compressed, the map has to line them back up
+	const auto gateMap = simulator.compressGates();
+	ASSERT_EQ(simulator.getDecomissionedCount(), 0);
+	for (int tick = 0; tick < 50; ++tick) {
+		const std::vector<logic_state_t> states = simulator.getCurrentState();
+		const std::vector<logic_state_t> referenceStates = reference.getCurrentState();
+		for (const auto& [oldGate, newGate] : gateMap) {
+			ASSERT_EQ(states[newGate], referenceStates[oldGate]) << "gate " << oldGate << " diverged on tick " << tick;
+		}
+		simulator.simulateNTicks(1);
+		reference.simulateNTicks(1);
+	}
+}
+
+TEST_F(SimulatorTest, MetricsCountTicks) {
+	if (!METRICS_ENABLED) GTEST_SKIP() << "built without GATALITY_METRICS";
+	// ring of three inverters never settles so every tick is computed
+	block_id_t first = simulator.addGate(GateType::NOR);
+	block_id_t second = simulator.addGate(GateType::NOR);
+	block_id_t third = simulator.addGate(GateType::NOR);
+	simulator.connectGates(first, second);
+	simulator.connectGates(second, third);
+	simulator.connectGates(third, first);
+
+	const SimulatorMetrics before = simulator.getMetrics();
+	simulator.queueTicks(100).wait();
+	const SimulatorMetrics after = simulator.getMetrics();
+	ASSERT_EQ(after.ticks - before.ticks, 100);
+	ASSERT_GT(after.gatesToggled, before.gatesToggled);
+	ASSERT_GT(after.computeTime_ns, before.computeTime_ns);
+	unsigned long long histogramTicks = 0;
+	for (unsigned int i = 0; i < TICK_HISTOGRAM_BUCKETS; ++i) {
+		histogramTicks += after.tickDurationHistogram[i] - before.tickDurationHistogram[i];
+	}
+	ASSERT_EQ(histogramTicks, 100);
+	ASSERT_EQ(after.editQueueDepth, 0);
+	ASSERT_NE(after.toJson().find("\"ticks\":" + std::to_string(after.ticks)), std::string::npos);
+}
+
+TEST_F(SimulatorTest, FillGateHolesOnlyMovesTail) {
+	// the event lists can still hold removed gates when the holes get filled
+	for (EvaluationMode mode : { EvaluationMode::SWEEP, EvaluationMode::EVENT_DRIVEN, EvaluationMode::LEVELIZED }) {
+		SCOPED_TRACE("mode " + std::to_string((int)mode));
+		LogicSimulator filled;
+		LogicSimulator reference;
+		filled.setEvaluationMode(mode);
+		reference.setEvaluationMode(mode);
+		const int gateCount = 1000;
+		std::mt19937 random = buildRandomCircuit({ &filled, &reference }, gateCount, gateCount * 3, 5);
+		filled.simulateNTicks(3);
+		reference.simulateNTicks(3);
+		std::set<block_id_t> removed;
+		for (int i = 0; i < 50; ++i) {
+			block_id_t gate = random() % gateCount;
+			filled.decomissionGate(gate);
+			reference.decomissionGate(gate);
+			removed.insert(gate);
+		}
+
+		const auto moves = filled.fillGateHoles();
+		ASSERT_EQ(filled.getGateCount(), gateCount - removed.size());
+		ASSERT_EQ(filled.getDecomissionedCount(), 0);
+		ASSERT_LE(moves.size(), removed.size());
+		std::vector<block_id_t> newIds(gateCount);
+		for (block_id_t gate = 0; gate < gateCount; ++gate) newIds[gate] = gate;
+		for (const auto& [oldGate, newGate] : moves) {
+			ASSERT_GE(oldGate, filled.getGateCount());
+			ASSERT_TRUE(removed.contains(newGate));
+			newIds[oldGate] = newGate;
+		}
+		for (int tick = 0; tick < 30; ++tick) {
+			filled.simulateNTicks(1);
+			reference.simulateNTicks(1);
+			const std::vector<logic_state_t> states = filled.getCurrentState();
+			const std::vector<logic_state_t> referenceStates = reference.getCurrentState();
+			for (block_id_t gate = 0; gate < gateCount; ++gate) {
+				if (removed.contains(gate)) continue;
+				ASSERT_EQ(states[newIds[gate]], referenceStates[gate]) << "gate " << gate << " diverged on tick " << tick;
+			}
+		}
+	}
+}
+
+TEST_F(SimulatorTest, LocalityReorderKeepsBehaviour) {
+	LogicSimulator reference;
+	const int gateCount = 1000;
+	buildRandomCircuit({ &simulator, &reference }, gateCount, gateCount * 2, 7);
+	simulator.decomissionGate(10);
+	reference.decomissionGate(10);
+	simulator.simulateNTicks(3);
+	reference.simulateNTicks(3);
+
+	// orders that skip a gate or list one twice are rejected before anything changes
+	std::vector<block_id_t> badOrder = simulator.getLocalityOrder();
+	ASSERT_EQ(badOrder.size(), gateCount - 1);
+	badOrder.back() = badOrder.front();
+	ASSERT_THROW(simulator.reorderGates(badOrder), std::invalid_argument);
+
+	std::vector<block_id_t> newIds(gateCount);
+	for (block_id_t gate = 0; gate < gateCount; ++gate) newIds[gate] = gate;
+	for (const auto& [oldGate, newGate] : simulator.reorderGates(simulator.getLocalityOrder())) {
+		newIds[oldGate] = newGate;
+	}
+	ASSERT_EQ(simulator.getGateCount(), gateCount - 1);
+	for (int tick = 0; tick < 30; ++tick) {
+		const std::vector<logic_state_t> states = simulator.getCurrentState();
+		const std::vector<logic_state_t> referenceStates = reference.getCurrentState();
+		for (block_id_t gate = 0; gate < gateCount; ++gate) {
+			if (gate == 10) continue;
+			ASSERT_EQ(states[newIds[gate]], referenceStates[gate]) << "gate " << gate << " diverged on tick " << tick;
+		}
+		simulator.simulateNTicks(1);
+		reference.simulateNTicks(1);
+	}
+}
+
+TEST_F(SimulatorTest, KnowsTheSimulationThread) {
+	ASSERT_FALSE(simulator.onSimulationThread());
+	bool inEdit = false;
+	simulator.queueEdit([this, &inEdit]() { inEdit = simulator.onSimulationThread(); }).get();
+	ASSERT_TRUE(inEdit);
+}
@@ -2,6 +2,7 @@
 #define simulatorTest_h
 
 #include <gtest/gtest.h>
+#include <random>
 #include "backend/evaluator/logicSimulator.h"
 
 class SimulatorTest : public ::testing::Test {
@@ -9,6 +10,16 @@ protected:
     void SetUp() override;
     void TearDown() override;
 
+    // gives every simulator the same gateCount gates of random types and edgeCount random connections, feedback
+    // loops included, so the gate ids line up between them. the first inputCount gates are inputs nothing
+    // connects to and acyclic only connects lower ids to higher ones. tests keep drawing from the generator
+    static std::mt19937 buildRandomCircuit(const std::vector<LogicSimulator*>& simulators, int gateCount, int edgeCount, unsigned int seed,
+        const std::vector<GateType>& types = ANY_GATE_TYPES, int inputCount = 0, bool acyclic = false);
+
+    static const std::vector<GateType> ANY_GATE_TYPES;
+    // only gates that compute their state from their inputs
+    static const std::vector<GateType> LOGIC_GATE_TYPES;
+
     LogicSimulator simulator;
 };
 